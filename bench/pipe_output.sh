@@ -0,0 +1,35 @@
+#!/bin/sh
+#
+# compares video output paths of avs2pipemod when stdout is a pipe.
+#
+#   usage: bench/pipe_output.sh [path to avs2pipemod] [frames]
+#
+# synthetic 1080p and 2160p clips (8bit and 16bit 4:2:0) are written to
+# 'cat > /dev/null' with the default fwrite path, the writev path and the
+# vmsplice path. cat copies the data out with read(), which -vmsplice
+# needs. avs2pipemod has to be built for Linux for the last two.
+
+A2PM=${1:-avs2pipemod}
+FRAMES=${2:-500}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+run() {
+    start=$(date +%s.%N)
+    "$A2PM" "$@" 2>/dev/null | cat > /dev/null
+    end=$(date +%s.%N)
+    echo "$start $end $FRAMES" | awk '{ printf "%8.3f sec  %8.2f fps\n", $2 - $1, $3 / ($2 - $1) }'
+}
+
+for size in 1920x1080 3840x2160; do
+    w=${size%x*}
+    h=${size#*x}
+    for fmt in YV12 YUV420P16; do
+        avs="$TMP/${size}_${fmt}.avs"
+        echo "BlankClip(length=$FRAMES, width=$w, height=$h, pixel_type=\"$fmt\", color_yuv=\$408080)" > "$avs"
+        echo "== ${size} ${fmt}"
+        printf "  fwrite   : "; run -y4mp "$avs"
+        printf "  writev   : "; run -y4mp -writev "$avs"
+        printf "  vmsplice : "; run -y4mp -vmsplice "$avs"
+    done
+done
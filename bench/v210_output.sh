@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# compares v210 output of avs2pipemod with plain planar rawvideo.
+#
+#   usage: bench/v210_output.sh [path to avs2pipemod] [frames]
+#
+# synthetic 1080p and 2160p 10bit 4:2:2 clips are written to
+# 'cat > /dev/null' as planar YUV422P10 (-rawvideo) and packed v210
+# (-rawvideo=v210). fps and output MB/s are reported for both.
+
+A2PM=${1:-avs2pipemod}
+FRAMES=${2:-500}
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# run <bytes per frame> <options...>
+run() {
+    bytes=$1
+    shift
+    start=$(date +%s.%N)
+    "$A2PM" "$@" 2>/dev/null | cat > /dev/null
+    end=$(date +%s.%N)
+    echo "$start $end $FRAMES $bytes" | awk '{
+        t = $2 - $1
+        printf "%8.3f sec  %8.2f fps  %9.1f MB/s\n", t, $3 / t, $3 * $4 / t / 1048576
+    }'
+}
+
+for size in 1920x1080 3840x2160; do
+    w=${size%x*}
+    h=${size#*x}
+    avs="$TMP/${size}.avs"
+    echo "BlankClip(length=$FRAMES, width=$w, height=$h, pixel_type=\"YUV422P10\", color_yuv=\$408080)" > "$avs"
+    planar=$((w * h * 4))
+    v210=$(((w + 47) / 48 * 128 * h))
+    echo "== ${size} YUV422P10"
+    printf "  planar : "; run $planar -rawvideo "$avs"
+    printf "  v210   : "; run $v210 -rawvideo=v210 "$avs"
+done
@@ -19,28 +19,47 @@
 */
 
 
-#include <sys/timeb.h>
+#include <chrono>
 #include <ctime>
 #include <io.h>
 #include <fcntl.h>
 #include <cstdio>
 #include <cinttypes>
 #include <format>
-#include <sstream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
 #include "avs2pipemod.h"
+#include "convert.h"
+#include "framehash.h"
+#include "framelist.h"
+#include "framestats.h"
+#include "framequeue.h"
+#include "jsonwriter.h"
+#include "latency.h"
+#include "manifest.h"
+#include "metrics.h"
+#include "npy.h"
+#include "output.h"
+#include "prefetcher.h"
+#include "propscolumns.h"
+#include "propsdump.h"
+#include "propstats.h"
+#include "textdump.h"
 #include "utils.h"
 #include "wave.h"
 
 
 static const AVS_Linkage* AVS_linkage = nullptr;
 
+// in microseconds, from a monotonic clock.
 static inline int64_t get_current_time(void)
 {
-    timeb tb;
-    ftime(&tb);
-    return (static_cast<int64_t>(tb.time) * 1000 + static_cast<int64_t>(tb.millitm)) * 1000;
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+        steady_clock::now().time_since_epoch()).count();
 }
 
 
@@ -59,6 +78,11 @@ Avs2PipeMod::Avs2PipeMod(HMODULE d, ise_t* e, PClip c, const char* in, Params& p
 
     sampleBits = get_sample_bits(vi.pixel_type);
     numPlanes = get_num_planes(vi.pixel_type);
+    numLayout = 0;
+    flip = false;
+    numFields = 1;
+    fieldRow[0] = fieldRow[1] = 0;
+    chunk = {};
     params.channel_mask = 0;
     if (version > 3.72 && vi.IsChannelMaskKnown()) {
         params.channel_mask = vi.GetChannelMask();
@@ -68,6 +92,12 @@ Avs2PipeMod::Avs2PipeMod(HMODULE d, ise_t* e, PClip c, const char* in, Params& p
 
 Avs2PipeMod::~Avs2PipeMod()
 {
+    prefetcher.reset();
+    converter.reset();
+    // workers and the reference clear AVS_linkage when they go away.
+    reference.reset();
+    workers.clear();
+    AVS_linkage = env->GetAVSLinkage();
     clip.~PClip();
     AVS_linkage = nullptr;
     env->DeleteScriptEnvironment();
@@ -78,27 +108,227 @@ Avs2PipeMod::~Avs2PipeMod()
 void Avs2PipeMod::
 invokeFilter(const char* filter, AVSValue args, const char** names)
 {
-    a2pm_log(LOG_INFO, "invoking %s ...\n", filter);
+    if (!params.quiet) {
+        a2pm_log(LOG_INFO, "invoking %s ...\n", filter);
+    }
     try {
         clip = env->Invoke(filter, args, names).AsClip();
         vi = clip->GetVideoInfo();
+        sampleBits = get_sample_bits(vi.pixel_type);
+        numPlanes = get_num_planes(vi.pixel_type);
     } catch (AvisynthError& e) {
         throw std::runtime_error(e.msg);
     }
 }
 
 
+// for conversions done in the output loop, the clip itself is left as is.
+void Avs2PipeMod::setPixelType(int pixel_type)
+{
+    vi.pixel_type = pixel_type;
+    sampleBits = get_sample_bits(pixel_type);
+    numPlanes = get_num_planes(pixel_type);
+}
+
+
 void Avs2PipeMod::trim()
 {
-    if (params.trimstart == 0 && params.trimend == 0) {
-        return;
+    if (params.trimstart != 0 || params.trimend != 0) {
+        AVSValue array[] = { clip, params.trimstart, params.trimend };
+        invokeFilter("Trim", AVSValue(array, 3));
+    }
+
+    if (params.frames) {
+        validate(!vi.HasVideo(), "clip has no video.\n");
+        auto ranges = read_frame_list(params.frames, vi.num_frames);
+        clip = create_frame_map(clip, ranges);
+        vi = clip->GetVideoInfo();
+        if (!params.quiet) {
+            a2pm_log(LOG_INFO, "taking %d frames in %zu ranges from %s.\n",
+                     vi.num_frames, ranges.size(), params.frames);
+        }
     }
+}
+
 
-    AVSValue array[] = { clip, params.trimstart, params.trimend };
+// the frames of the chunk only depend on the number of frames of the clip,
+// so that every machine of a render farm cuts it at the same boundaries.
+void Avs2PipeMod::selectChunk()
+{
+    if (params.chunks < 1 && params.chunkSize < 1) {
+        return;
+    }
+    validate(!params.output_path, "-chunks and -chunk-size need -o.\n");
+
+    const int64_t num = vi.num_frames;
+    int64_t first, last;
+    if (params.chunkSize > 0) {
+        chunk.count = static_cast<int>((num + params.chunkSize - 1) / params.chunkSize);
+        first = static_cast<int64_t>(params.chunkIndex) * params.chunkSize;
+        last = std::min(first + params.chunkSize, num) - 1;
+    } else {
+        chunk.count = params.chunks;
+        first = num * params.chunkIndex / params.chunks;
+        last = num * (params.chunkIndex + 1) / params.chunks - 1;
+    }
+    validate(params.chunkIndex >= chunk.count,
+             std::format("chunk index {} is out of {} chunks.\n",
+                         params.chunkIndex, chunk.count));
+    validate(last < first, std::format("chunk {} has no frames.\n",
+                                       params.chunkIndex));
+    chunk.index = params.chunkIndex;
+    chunk.first = static_cast<int>(first);
+    chunk.last = static_cast<int>(last);
+
+    if (!params.quiet) {
+        a2pm_log(LOG_INFO, "rendering chunk %d of %d, frames %d-%d.\n",
+                 chunk.index, chunk.count, chunk.first, chunk.last);
+    }
+    AVSValue array[] = { clip, chunk.first, chunk.first - chunk.last - 1 };
     invokeFilter("Trim", AVSValue(array, 3));
 }
 
 
+void Avs2PipeMod::startPrefetch(int first)
+{
+    if (params.workers > 1 && vi.num_frames - first > 1) {
+        startWorkers(first);
+        return;
+    }
+    if (params.prefetch < 1 || vi.num_frames - first < 2) {
+        return;
+    }
+
+    if (!params.quiet) {
+        a2pm_log(LOG_INFO, "prefetching up to %d frames with %d threads.\n",
+                 params.prefetch, params.prefetch);
+    }
+    auto fetch = [this](int n, int) { return clip->GetFrame(n, env); };
+    prefetcher = std::make_unique<FramePrefetcher>(
+        fetch, vi.num_frames, params.prefetch, params.prefetch, 1, first);
+}
+
+
+// for scripts that are not MT-safe. every worker imports the script into
+// its own environment and renders chunks of consecutive frames. the
+// environment of this instance is left to the main thread, which still
+// takes audio and frame properties from it.
+void Avs2PipeMod::startWorkers(int first)
+{
+    if (!params.quiet) {
+        a2pm_log(LOG_INFO, "rendering chunks of %d frames with %d script "
+                 "environments.\n", params.chunk, params.workers);
+    }
+
+    // the workers overwrite some of the params, and would repeat the
+    // messages of this instance.
+    workerParams = params;
+    workerParams.quiet = true;
+    const VideoInfo& src = clip->GetVideoInfo();
+    for (int i = 0; i < params.workers; ++i) {
+        std::unique_ptr<Avs2PipeMod> w(create(input, workerParams));
+        w->prepareVideoClip();
+        const VideoInfo& wvi = w->clip->GetVideoInfo();
+        validate(wvi.num_frames != src.num_frames || wvi.width != src.width
+                    || wvi.height != src.height || wvi.pixel_type != src.pixel_type,
+                 "the script returned a different clip in another environment.\n");
+        workers.push_back(std::move(w));
+    }
+
+    auto fetch = [this](int n, int worker) {
+        Avs2PipeMod* w = workers[worker].get();
+        return w->clip->GetFrame(n, w->env);
+    };
+    prefetcher = std::make_unique<FramePrefetcher>(
+        fetch, vi.num_frames, params.workers, params.workers * params.chunk,
+        params.chunk, first);
+}
+
+
+PVideoFrame Avs2PipeMod::getFrame(int n)
+{
+    return prefetcher ? prefetcher->get(n) : clip->GetFrame(n, env);
+}
+
+
+// crop, vflip and fields are done by moving the pointers and pitches of the
+// planes, without copying the frames.
+void Avs2PipeMod::setupPlanes()
+{
+    const int planes[] = {
+        0,
+        vi.IsYUV() ? PLANAR_U : PLANAR_B,
+        vi.IsYUV() ? PLANAR_V : PLANAR_R,
+        PLANAR_A
+    };
+    const int left = params.cropleft;
+    const int top = params.croptop;
+    const int right = params.cropright;
+    const int bottom = params.cropbottom;
+    validate(left + right >= vi.width || top + bottom >= vi.height,
+             "crop margins are larger than the frame.\n");
+
+    // packed RGB is stored bottom-up.
+    const bool bottomup = vi.IsRGB() && !vi.IsPlanar();
+    flip = params.format_type == FMT_RAWVIDEO_VFLIP;
+    numLayout = numPlanes;
+    for (int p = 0; p < numPlanes; ++p) {
+        const int plane = planes[p];
+        int sw = 0;
+        int sh = 0;
+        if (p > 0) {
+            sw = vi.GetPlaneWidthSubsampling(plane);
+            sh = vi.GetPlaneHeightSubsampling(plane);
+        }
+        // YUY2 has pairs of pixels sharing U and V, but no chroma planes.
+        const int cw = vi.IsYUY2() ? 1 : sw;
+        validate(((left | right) & ((1 << cw) - 1))
+                    || ((top | bottom) & ((1 << sh) - 1)),
+                 "crop margins have to be multiples of chroma subsampling.\n");
+        layout[p].plane = plane;
+        layout[p].left = vi.BytesFromPixels(left >> sw);
+        layout[p].top = (bottomup ? bottom : top) >> sh;
+        layout[p].rowsize = vi.BytesFromPixels((vi.width - left - right) >> sw);
+        layout[p].height = (vi.height - top - bottom) >> sh;
+        validate(params.fields && (layout[p].height & 1),
+                 "frame height cannot be split into fields.\n");
+    }
+    vi.width -= left + right;
+    vi.height -= top + bottom;
+
+    if (params.fields) {
+        // the top field is the even rows of the picture as it is written.
+        // with vflip, and for packed RGB that is stored bottom-up, those are
+        // the odd rows in memory, as the height is even.
+        numFields = 2;
+        fieldRow[0] = (params.fields == 'b') != (bottomup || flip) ? 1 : 0;
+        fieldRow[1] = 1 - fieldRow[0];
+        for (int p = 0; p < numPlanes; ++p) {
+            layout[p].height /= 2;
+        }
+        vi.height /= 2;
+        vi.MulDivFPS(2, 1);
+    }
+}
+
+
+void Avs2PipeMod::getPlanes(const PVideoFrame& frame, plane_t* views, int field)
+{
+    for (int p = 0; p < numLayout; ++p) {
+        const plane_layout_t& l = layout[p];
+        int pitch = frame->GetPitch(l.plane);
+        const uint8_t* ptr = frame->GetReadPtr(l.plane) + l.top * pitch + l.left;
+        ptr += fieldRow[field] * pitch;
+        pitch *= numFields;
+        if (flip) {
+            ptr += (l.height - 1) * pitch;
+            pitch = -pitch;
+        }
+        views[p] = { ptr, l.rowsize, pitch, l.height };
+    }
+}
+
+
 void Avs2PipeMod::info(bool act_info)
 {
     printf("\navisynth_version %.3f / %s\n", version, versionString);
@@ -140,6 +370,8 @@ void Avs2PipeMod::info(bool act_info)
 }
 
 
+// every GetFrame() is timed on its own, so stalls on scene cuts or seeks
+// show up in the percentiles and the slowest frames.
 void Avs2PipeMod::benchmark()
 {
     constexpr int FRAMES_PER_OUT = 50;
@@ -147,45 +379,69 @@ void Avs2PipeMod::benchmark()
     trim();
     info(false);
 
-    int surplus = vi.num_frames % FRAMES_PER_OUT;
     int passed = 0;
+    LatencyHistogram latency;
 
     a2pm_log(LOG_INFO, "benchmarking %d frames video.\n", vi.num_frames);
 
-    int64_t start = get_current_time();
-    int64_t elapsed;
-
-    while (passed < surplus) {
-        clip->GetFrame(passed++, env);
-    }
+    using clock = std::chrono::steady_clock;
+    const auto start = clock::now();
+    auto last = start;
 
     while (passed < vi.num_frames) {
-        elapsed = get_current_time() - start;
-        double de = elapsed * 0.000001;
-        fprintf(stderr, "\r"
-                "avs2pipemod[info]: [elapsed %.3f sec] %d/%d frames "
-                "[%3d%%][%.3ffps]",
-                de, passed, vi.num_frames, passed * 100 / vi.num_frames,
-                passed / de);
-        for (int n = 0; n < FRAMES_PER_OUT; ++n) {
-            clip->GetFrame(passed++, env);
+        if (passed % FRAMES_PER_OUT == 0 && passed > 0) {
+            double de = std::chrono::duration<double>(last - start).count();
+            fprintf(stderr, "\r"
+                    "avs2pipemod[info]: [elapsed %.3f sec] %d/%d frames "
+                    "[%3d%%][%.3ffps]",
+                    de, passed, vi.num_frames, passed * 100 / vi.num_frames,
+                    passed / de);
         }
+        const auto t = clock::now();
+        clip->GetFrame(passed, env);
+        last = clock::now();
+        latency.add(passed++, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            last - t).count());
     }
 
-    elapsed = get_current_time() - start;
+    const double elapsed = std::chrono::duration<double>(last - start).count();
 
     fprintf(stderr, "\n");
     printf("benchmark result: total elapsed time is %.3f sec [%.3ffps]\n",
-            elapsed / 1000000.0, passed * 1000000.0 / elapsed);
+            elapsed, passed / elapsed);
+    fputs(latency.summary().c_str(), stdout);
     fflush(stdout);
 
+    if (params.benchmarkJson) {
+        std::string text;
+        JsonWriter w(text);
+        w.beginObject();
+        w.key("frames");
+        w.value(static_cast<int64_t>(passed));
+        w.key("elapsed");
+        w.value(elapsed, 6);
+        w.key("fps");
+        w.value(passed / elapsed, 3);
+        w.key("latency");
+        latency.write(w);
+        w.endObject();
+        text += '\n';
+
+        FILE* fp = fopen(params.benchmarkJson, "w");
+        validate(!fp, std::format("failed to open {}.\n", params.benchmarkJson));
+        const bool ok = fwrite(text.data(), 1, text.size(), fp) == text.size();
+        fclose(fp);
+        validate(!ok, std::format("failed to write {}.\n", params.benchmarkJson));
+    }
+
     validate(passed != vi.num_frames,
         std::format("only passed {} of {} frames.\n", passed, vi.num_frames));
 }
 
 
-static void write_audio_file_header(Params& pr, const VideoInfo& vi,
-    float version)
+// the sizes in the header are those of the complete file, so the header is
+// valid as it is when an output is resumed.
+static std::string get_audio_file_header(Params& pr, const VideoInfo& vi)
 {
     WaveFormatType format = vi.sample_type == SAMPLE_FLOAT ?
         WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
@@ -200,13 +456,13 @@ static void write_audio_file_header(Params& pr, const VideoInfo& vi,
 
     if (pr.format_type == FMT_WAVEFORMATEXTENSIBLE) {
         auto header = WaveRiffExtHeader(args);
-        fwrite(&header, sizeof(header), 1, stdout);
-        return;
+        return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
     }
     if (pr.format_type == FMT_WAVEFORMATEX) {
         auto header = WaveRiffHeader(args);
-        fwrite(&header, sizeof(header), 1, stdout);
+        return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
     }
+    return std::string();
 }
 
 
@@ -223,7 +479,6 @@ void Avs2PipeMod::outAudio()
         invokeFilter(filter.c_str(), clip);
     }
 
-    size_t step = 0;
     size_t count = vi.audio_samples_per_second;
     size_t size = vi.BytesPerChannelSample() * vi.nchannels;
     uint64_t target = vi.num_audio_samples;
@@ -233,28 +488,64 @@ void Avs2PipeMod::outAudio()
     a2pm_log(LOG_INFO, "writing %.3f seconds of %zu Hz, %d channel audio.\n",
              1.0 * target / count, count, vi.nchannels);
 
+    std::unique_ptr<Checkpoint> cp;
+    if (params.resume > 0) {
+        validate(!params.output_path, "-resume needs -o.\n");
+        cp = std::make_unique<Checkpoint>(params.output_path, params.resume,
+                                          target);
+    }
+
+    auto out = create_output(OUT_STDIO, params.output_path, 0,
+                             sizeof(WaveRiffExtHeader) + target * size,
+                             cp ? cp->bytes : 0);
+    HashOutput* hashed = nullptr;
+    if (cp) {
+        auto h = std::make_unique<HashOutput>(std::move(out), cp->hash, cp->bytes);
+        hashed = h.get();
+        out = std::move(h);
+    }
+
     int64_t elapsed = get_current_time();
 
+    std::string header;
     if (params.format_type != FMT_RAWAUDIO) {
         if (version > 3.72 && vi.IsChannelMaskKnown()) {
             params.channel_mask = vi.GetChannelMask();
         }
-        write_audio_file_header(params, vi, version);
+        header = get_audio_file_header(params, vi);
+    }
+    if (cp) {
+        cp->setHeader(header.data(), header.size());
     }
 
-    clip->GetAudio(data, 0, target % count, env);
-    uint64_t wrote = fwrite(data, size, target % count, stdout);
+    uint64_t wrote = cp ? cp->done : 0;
+    if (wrote == 0) {
+        out->write(header.data(), header.size());
+        clip->GetAudio(data, 0, target % count, env);
+        if (out->write(data, size * (target % count))) {
+            wrote = target % count;
+        }
+    }
 
     while (wrote < target) {
         clip->GetAudio(data, wrote, count, env);
-        step = fwrite(data, size, count, stdout);
-        if (step != count) break;
-        wrote += step;
+        if (!out->write(data, size * count)) break;
+        wrote += count;
         a2pm_log(LOG_REPEAT, "wrote %.3f seconds [%" PRIu64 "%%]",
                  1.0 * wrote / count, (100 * wrote) / target);
+        if (cp && wrote < target && cp->due()) {
+            validate(!out->sync(), "failed to write the output.\n");
+            cp->save(wrote, hashed->size(), hashed->state());
+        }
     }
 
-    fflush(stdout);
+    validate(!out->flush(), "failed to write the output.\n");
+    if (cp && wrote == target) {
+        cp->remove();
+    } else if (cp) {
+        cp->save(wrote, hashed->size(), hashed->state());
+    }
+    out.reset();
 
     elapsed = get_current_time() - elapsed;
 
@@ -266,38 +557,137 @@ void Avs2PipeMod::outAudio()
 }
 
 
+void Avs2PipeMod::convertBits(int bits)
+{
+    if (bits == sampleBits) {
+        return;
+    }
+    a2pm_log(LOG_INFO, "converting %d bits to %d bits ...\n", sampleBits, bits);
+    converter = create_depth_converter(vi, bits, params.dither,
+                                       std::move(converter));
+    validate(!converter, "unsupported format.");
+    setPixelType(set_sample_bits(vi.pixel_type, bits));
+}
+
+
+// filters added to the script for video output. workers add the same ones
+// to their own clips.
+void Avs2PipeMod::prepareVideoClip()
+{
+    trim();
+    selectChunk();
+
+    if (params.format_type == FMT_YUV4MPEG2 && vi.IsFieldBased()) {
+        const bool weave = params.fieldbased == 'w';
+        if (!params.quiet) {
+            a2pm_log(LOG_WARNING,
+                     "clip is FieldBased.\n"
+                     "%19s yuv4mpeg2's spec doesn't support fieldbased clip.\n"
+                     "%19s adding %s(). see '-fieldbased' to change this.\n",
+                     "", "", weave ? "Weave" : "AssumeFrameBased");
+        }
+        invokeFilter(weave ? "Weave" : "AssumeFrameBased", clip);
+    }
+}
+
+
 void Avs2PipeMod::prepareY4MOut()
 {
-    if (vi.IsFieldBased()) {
-        a2pm_log(LOG_WARNING,
-                 "clip is FieldBased.\n"
-                 "%19s yuv4mpeg2's spec doesn't support fieldbased clip.\n"
-                 "%19s choose what you want.\n"
-                 "%19s 1:add AssumeFrameBased()  2:add Weave()  others:exit\n"
-                 "%19s input a number and press enter : ",
-                 "", "", "", "");
-        int k = fgetc(stdin);
-        validate(k != '1' && k != '2', "good bye...\n");
-        invokeFilter(k == '1' ? "AssumeFrameBased" : "Weave", clip);
+    setupPlanes();
+    if (numFields == 2) {
+        // each field is a progressive picture.
+        params.frame_type = 'p';
     }
 
     if (vi.IsYUY2()) {
-        invokeFilter("ConvertToYV16", clip);
+        a2pm_log(LOG_INFO, "converting YUY2 to YV16 ...\n");
+        converter = create_yuy2_to_yv16(vi);
+        setPixelType(VideoInfo::CS_YV16);
     }
-    if (vi.IsRGB24() || vi.IsRGB32()) {
-        const char* names[] = {nullptr, "interlaced", "matrix"};
-        AVSValue args[] = {
-            clip,
-            params.frame_type != 'p',
-            vi.height < 720 ? "Rec601" : "Rec709"
-        };
-        invokeFilter("ConvertToYV24", AVSValue(args, 3), names);
+    if (vi.IsRGB()) {
+        bool rec709 = vi.height >= 720;
+        converter = create_rgb_to_yuv444(vi, rec709);
+        validate(!converter, "unsupported format.");
+        a2pm_log(LOG_INFO, "converting %s to YUV444 with %s coefficients ...\n",
+                 get_string_info(vi.pixel_type), rec709 ? "Rec.709" : "Rec.601");
+        switch (sampleBits) {
+        case 8:  setPixelType(VideoInfo::CS_YV24); break;
+        case 10: setPixelType(VideoInfo::CS_YUV444P10); break;
+        case 12: setPixelType(VideoInfo::CS_YUV444P12); break;
+        case 14: setPixelType(VideoInfo::CS_YUV444P14); break;
+        default: setPixelType(VideoInfo::CS_YUV444P16); break;
+        }
     }
-    if (vi.IsRGB48() || vi.IsRGB64() || vi.IsPlanarRGB()) {
-        throw std::runtime_error("unsupported format.");
+
+    // yuv4mpeg2 has no float formats, and no 10-14 bits for Y.
+    int bits = params.yuv_depth;
+    if (bits == 0 && (sampleBits == 32
+                      || (vi.IsY() && sampleBits > 8 && sampleBits < 16))) {
+        bits = 16;
     }
-    if (sampleBits == 32 || (vi.IsY() && (sampleBits >= 10 && sampleBits < 16))) {
-        invokeFilter("ConvertTo16bit", clip);
+    if (bits != 0) {
+        validate(vi.IsY() && bits != 8 && bits != 16,
+                 "yuv4mpeg2 supports only 8 and 16 bits for Y.");
+        convertBits(bits);
+    }
+}
+
+
+// sets up the converter of the rawvideo formats that avisynth doesn't have,
+// and returns the name of the output format.
+const char* Avs2PipeMod::prepareRawOut()
+{
+    setupPlanes();
+
+    switch (params.format_type) {
+    case FMT_RAWVIDEO_NV12:
+    case FMT_RAWVIDEO_P010:
+    case FMT_RAWVIDEO_P016: {
+        validate(!vi.Is420(), "nv12/p010/p016 require YUV420 input.\n");
+        // p016 keeps 10-14 bits, just aligned to MSB.
+        int bits = 8;
+        if (params.format_type == FMT_RAWVIDEO_P010) {
+            bits = 10;
+        } else if (params.format_type == FMT_RAWVIDEO_P016) {
+            bits = sampleBits > 8 && sampleBits <= 16 ? sampleBits : 16;
+        }
+        convertBits(bits);
+        converter = create_semiplanar(vi, bits == 8 ? 0 : 16 - bits,
+                                      std::move(converter));
+        return params.format_type == FMT_RAWVIDEO_NV12 ? "NV12" :
+               params.format_type == FMT_RAWVIDEO_P010 ? "P010" : "P016";
+    }
+    case FMT_RAWVIDEO_V210:
+        validate(!vi.Is422() && !vi.IsYUY2(), "v210 requires YUV422 input.\n");
+        if (vi.IsYUY2()) {
+            converter = create_yuy2_to_yv16(vi);
+            setPixelType(VideoInfo::CS_YV16);
+        }
+        convertBits(10);
+        converter = create_v210(vi, std::move(converter));
+        return "v210";
+    case FMT_RAWVIDEO_RGB24:
+    case FMT_RAWVIDEO_BGR24:
+    case FMT_RAWVIDEO_RGB48:
+    case FMT_RAWVIDEO_RGBA: {
+        validate(!vi.IsPlanarRGB() && !vi.IsPlanarRGBA(),
+                 "rgb24/bgr24/rgb48/rgba require planar RGB input.\n");
+        const bool rgba = params.format_type == FMT_RAWVIDEO_RGBA;
+        const bool wide = params.format_type == FMT_RAWVIDEO_RGB48
+                          || (rgba && sampleBits > 8);
+        validate(params.byteswap && !wide,
+                 "-byteswap needs 16bit samples of rgb48 or rgba.\n");
+        convertBits(wide ? 16 : 8);
+        converter = create_rgb_packer(vi, params.format_type == FMT_RAWVIDEO_BGR24,
+                                      rgba ? 4 : 3, params.byteswap,
+                                      std::move(converter));
+        return params.format_type == FMT_RAWVIDEO_RGB24 ? "rgb24" :
+               params.format_type == FMT_RAWVIDEO_BGR24 ? "bgr24" :
+               params.format_type == FMT_RAWVIDEO_RGB48 ? "rgb48" :
+               wide ? "rgba64" : "rgba";
+    }
+    default:
+        return get_string_video_out(vi.pixel_type);
     }
 }
 
@@ -326,23 +716,50 @@ static void set_frame_props(Params& p, PVideoFrame& vf, ise_t* env)
 template <bool Y4MOUT>
 int Avs2PipeMod::writeFrames()
 {
-    const int planes[] = {
-        0,
-        vi.IsYUV() ? PLANAR_U : PLANAR_B,
-        vi.IsYUV() ? PLANAR_V : PLANAR_R,
-        PLANAR_A
-    };
+    std::unique_ptr<Checkpoint> cp;
+    if (params.resume > 0) {
+        validate(!params.output_path, "-resume needs -o.\n");
+        cp = std::make_unique<Checkpoint>(params.output_path, params.resume,
+                                          vi.num_frames);
+    }
+    const int first = cp ? static_cast<int>(cp->done) : 0;
 
     const size_t buffsize = vi.BitsPerPixel() * vi.width * vi.height / 8;
-    auto b = Buffer(buffsize, 64);
-    uint8_t* buff = reinterpret_cast<uint8_t*>(b.data());
+    auto out = create_output(params.output, params.output_path, buffsize,
+                             (buffsize + 6) * vi.num_frames * numFields + 256,
+                             cp ? cp->bytes : 0);
+    if (params.framehash) {
+        auto hasher = std::make_unique<FrameHasher>(params.framehash,
+                                                    params.framehashPath);
+        hasher->writeHeader(vi, true, false, params.sarnum, params.sarden);
+        out = std::make_unique<FrameHashOutput>(std::move(out), std::move(hasher),
+                                                first * numFields);
+    }
+    HashOutput* hashed = nullptr;
+    if (chunk.count > 0 || cp) {
+        auto h = cp ? std::make_unique<HashOutput>(std::move(out), cp->hash, cp->bytes)
+                    : std::make_unique<HashOutput>(std::move(out));
+        hashed = h.get();
+        out = std::move(h);
+    }
 
-    auto frame = clip->GetFrame(0, env);
-    int wrote = 0;
+    // the stream header always takes the properties of the first frame of
+    // the clip, also when the output is resumed after it.
+    PVideoFrame head;
+    if (Y4MOUT && first > 0 && version >= 3.70) {
+        head = clip->GetFrame(0, env);
+    }
+    startPrefetch(first);
+    auto frame = getFrame(first);
+    int wrote = first;
 
     if constexpr (Y4MOUT) {
         if (version >= 3.70) {
-            set_frame_props(params, frame, env);
+            set_frame_props(params, head ? head : frame, env);
+            head = nullptr;
+        }
+        if (converter) {
+            converter->updateParams(params);
         }
         const char* range = "";
         if (params.colorrange == 0) {
@@ -357,54 +774,319 @@ int Avs2PipeMod::writeFrames()
             vi.width, vi.height, vi.fps_numerator, vi.fps_denominator,
             params.frame_type, params.sarnum, params.sarden, color, range,
             params.colorprim, params.transfer, params.colormatrix);
-        puts(header.c_str());
+        header += "\n";
+        if (cp) {
+            cp->setHeader(header.data(), header.size());
+        }
+        if (first == 0) {
+            out->write(header.data(), header.size());
+        }
+        chunk.header = header.size();
     }
 
-    while (true) {
-        if constexpr (Y4MOUT) {
-            puts("FRAME");
-        }
-        for (int p = 0; p < numPlanes; ++p) {
-            int plane = planes[p];
-            const uint8_t* srcp = frame->GetReadPtr(plane);
-            int rowsize = frame->GetRowSize(plane);
-            int pitch = frame->GetPitch(plane);
-            int height = frame->GetHeight(plane);
-            size_t count = rowsize * height;
-            size_t step = 0;
-
-            if (rowsize == pitch) {
-                step = fwrite(srcp, 1, count, stdout);
+    auto write_frame = [&](const PVideoFrame& frame) {
+        for (int field = 0; field < numFields; ++field) {
+            plane_t views[4];
+            getPlanes(frame, views, field);
+            bool ok;
+            if (converter) {
+                plane_t converted[4];
+                int num = converter->convert(views, converted);
+                ok = out->writeFrame(Y4MOUT ? "FRAME\n" : nullptr, converted, num,
+                                     PVideoFrame());
             } else {
-                env->BitBlt(buff, rowsize, srcp, pitch, rowsize, height);
-                step = fwrite(buff, 1, count, stdout);
+                ok = out->writeFrame(Y4MOUT ? "FRAME\n" : nullptr, views, numLayout,
+                                     frame);
+            }
+            if (!ok) {
+                return false;
             }
-            if (step != count) {
-                goto finish;
+        }
+        return true;
+    };
+
+    // called after each frame, on the thread that writes. a complete file
+    // never gets a checkpoint, which would make the next run append to it,
+    // and a checkpoint only covers data that is on the disk. returns false
+    // if the output has failed.
+    auto checkpoint = [&] {
+        if (cp && wrote < vi.num_frames && cp->due()) {
+            if (!out->sync()) {
+                return false;
+            }
+            cp->save(wrote, hashed->size(), hashed->state());
+        }
+        return true;
+    };
+
+    if (params.queue < 1) {
+        while (write_frame(frame)) {
+            ++wrote;
+            if (!checkpoint() || wrote >= vi.num_frames) break;
+            frame = getFrame(wrote);
+        }
+    } else {
+        // render on this thread, write on another one.
+        a2pm_log(LOG_INFO, "writing frames on a separate thread through "
+                 "%d frames queue.\n", params.queue);
+        auto queue = FrameQueue(params.queue);
+        std::atomic<bool> failed = false;
+        std::thread writer([&] {
+            while (auto f = queue.pop()) {
+                if (failed || !write_frame(f)) {
+                    failed = true;
+                    continue;
+                }
+                ++wrote;
+                if (!checkpoint()) {
+                    failed = true;
+                }
+            }
+        });
+
+        try {
+            queue.push(frame);
+            frame = nullptr;
+            for (int n = first + 1; n < vi.num_frames && !failed; ++n) {
+                queue.push(getFrame(n));
             }
+        } catch (...) {
+            queue.close();
+            writer.join();
+            throw;
         }
-        if (++wrote >= vi.num_frames) break;
-        frame = clip->GetFrame(wrote, env);
+        queue.close();
+        writer.join();
     }
 
-finish:
-    fflush(stdout);
+    validate(!out->flush(), "failed to write the output.\n");
+    if (hashed) {
+        chunk.bytes = hashed->size();
+        chunk.hash = hashed->digest();
+    }
+    if (cp && wrote == vi.num_frames) {
+        cp->remove();
+    } else if (cp) {
+        cp->save(wrote, hashed->size(), hashed->state());
+    }
+    prefetcher.reset();
     return wrote;
 }
 
 
+// hashes the frames as -rawvideo writes them, and the audio in blocks of
+// the length of a frame, without writing them.
+void Avs2PipeMod::frameHash()
+{
+    trim();
+    const bool video = vi.HasVideo();
+    const bool audio = vi.HasAudio();
+    validate(!video && !audio, "clip has no video and audio.\n");
+    const VideoInfo src = vi;
+    if (video) {
+        setupPlanes();
+    }
+
+    // with -fields, pts counts fields. the time base is that of the fields,
+    // and every field carries the audio of half a frame.
+    auto audio_at = [&](int64_t pts) {
+        return pts * src.audio_samples_per_second * src.fps_denominator
+            / (static_cast<int64_t>(src.fps_numerator) * numFields);
+    };
+    VideoInfo tb = vi;
+    tb.fps_numerator = src.fps_numerator;
+    tb.fps_denominator = src.fps_denominator;
+    if (video && numFields > 1) {
+        tb.MulDivFPS(numFields, 1);
+    }
+
+    FrameHasher hasher(params.framehash, params.framehashPath);
+    hasher.writeHeader(tb, video, audio, params.sarnum, params.sarden);
+    a2pm_log(LOG_INFO, "hashing %d frames and %" PRId64 " samples.\n",
+             video ? vi.num_frames * numFields : 0,
+             audio ? vi.num_audio_samples : 0);
+
+    const int64_t bps = audio ? vi.BytesPerAudioSample() : 0;
+    std::vector<uint8_t> buff;
+    auto hash_audio = [&](int64_t start, int64_t end) {
+        end = std::min(end, vi.num_audio_samples);
+        if (end <= start) {
+            return;
+        }
+        buff.resize(static_cast<size_t>((end - start) * bps));
+        clip->GetAudio(buff.data(), start, end - start, env);
+        hasher.addAudio(start, buff.data(), buff.size());
+    };
+
+    int64_t elapsed = get_current_time();
+
+    int64_t pts = 0;
+    if (video) {
+        startPrefetch(0);
+        for (int n = 0; n < vi.num_frames; ++n) {
+            auto frame = getFrame(n);
+            for (int field = 0; field < numFields; ++field, ++pts) {
+                plane_t views[4];
+                getPlanes(frame, views, field);
+                hasher.addVideo(pts, views, numLayout, frame);
+                if (audio) {
+                    hash_audio(audio_at(pts), audio_at(pts + 1));
+                }
+            }
+        }
+        prefetcher.reset();
+    }
+    // audio that is longer than the video.
+    int64_t start = video ? audio_at(pts) : 0;
+    for (; audio && start < vi.num_audio_samples; start += 1024) {
+        hash_audio(start, start + 1024);
+    }
+    hasher.finish();
+
+    elapsed = get_current_time() - elapsed;
+    a2pm_log(LOG_INFO, "total elapsed time is %.3f sec.\n", elapsed / 1000000.0);
+}
+
+
+// the planes of the frames in the order of -dumptxt, and their names.
+static const int* get_planes(const VideoInfo& vi)
+{
+    static const int yuv[] = { 0, PLANAR_U, PLANAR_V, PLANAR_A };
+    static const int rgb[] = { 0, PLANAR_B, PLANAR_R, PLANAR_A };
+    return vi.IsYUV() ? yuv : rgb;
+}
+
+
+static std::vector<std::string> get_plane_names(const VideoInfo& vi, int num)
+{
+    if (num == 1) {
+        return { vi.IsY() ? "y" : "packed" };
+    }
+    std::vector<std::string> names;
+    for (int p = 0; p < num; ++p) {
+        names.push_back(std::string(1, (vi.IsYUV() ? "yuva" : "gbra")[p]));
+    }
+    return names;
+}
+
+
+static plane_t get_plane(const PVideoFrame& frame, int plane)
+{
+    return { frame->GetReadPtr(plane), frame->GetRowSize(plane),
+             frame->GetPitch(plane), frame->GetHeight(plane) };
+}
+
+
+// compares the frames with those of another script, which is imported into
+// its own environment. both clips are rendered ahead on threads of their
+// own while the frames are compared.
+void Avs2PipeMod::compare()
+{
+    validate(!vi.HasVideo(), "clip has no video.\n");
+    prepareVideoClip();
+
+    a2pm_log(LOG_INFO, "importing %s ...\n", params.compare);
+    referenceParams = params;
+    referenceParams.quiet = true;
+    reference.reset(create(params.compare, referenceParams));
+    Avs2PipeMod* ref = reference.get();
+    validate(!ref->vi.HasVideo(), "reference has no video.\n");
+    ref->prepareVideoClip();
+    validate(ref->vi.width != vi.width || ref->vi.height != vi.height
+                || ref->vi.pixel_type != vi.pixel_type,
+             std::format("the clip is {}x{} {}, but the reference is {}x{} {}.\n",
+                         vi.width, vi.height, get_string_info(vi.pixel_type),
+                         ref->vi.width, ref->vi.height,
+                         get_string_info(ref->vi.pixel_type)));
+    if (ref->vi.num_frames != vi.num_frames) {
+        a2pm_log(LOG_WARNING, "the clip has %d frames and the reference %d.\n",
+                 vi.num_frames, ref->vi.num_frames);
+        vi.num_frames = ref->vi.num_frames = std::min(vi.num_frames,
+                                                      ref->vi.num_frames);
+    }
+
+    const int* planes = get_planes(vi);
+    a2pm_log(LOG_INFO, "comparing %d frames of %dx%d %s with %s.\n",
+             vi.num_frames, vi.width, vi.height, get_string_info(vi.pixel_type),
+             params.compare);
+    CompareReport report(params.output_path, params.compareJson,
+                         get_plane_names(vi, numPlanes), sampleBits);
+
+    int64_t elapsed = get_current_time();
+
+    for (Avs2PipeMod* a : { this, ref }) {
+        if (params.prefetch > 0 || params.workers > 1) {
+            a->startPrefetch(0);
+        } else if (vi.num_frames > 1) {
+            auto fetch = [a](int n, int) { return a->clip->GetFrame(n, a->env); };
+            a->prefetcher = std::make_unique<FramePrefetcher>(
+                fetch, vi.num_frames, 1, 4);
+        }
+    }
+
+    std::vector<plane_metric_t> metrics(numPlanes);
+    for (int n = 0; n < vi.num_frames; ++n) {
+        auto fa = getFrame(n);
+        auto fb = ref->getFrame(n);
+        for (int p = 0; p < numPlanes; ++p) {
+            plane_t a = get_plane(fa, planes[p]);
+            plane_t b = get_plane(fb, planes[p]);
+            metrics[p] = sampleBits == 8 ? compare_plane<uint8_t>(a, b, 8) :
+                         sampleBits == 32 ? compare_plane<float>(a, b, 32) :
+                         compare_plane<uint16_t>(a, b, sampleBits);
+        }
+        report.add(n, metrics.data());
+    }
+    prefetcher.reset();
+    ref->prefetcher.reset();
+    report.finish();
+
+    elapsed = get_current_time() - elapsed;
+    a2pm_log(LOG_INFO, "total elapsed time is %.3f sec.\n", elapsed / 1000000.0);
+}
+
+
+// statistics of every plane of every frame, computed straight from the
+// frames on several threads while the next frames are rendered.
+void Avs2PipeMod::stats()
+{
+    validate(!vi.HasVideo(), "clip has no video.\n");
+    prepareVideoClip();
+
+    const int* planes = get_planes(vi);
+    FrameStats stats(params.output_path, params.statsJson,
+                     get_plane_names(vi, numPlanes), sampleBits,
+                     params.statsBins);
+    a2pm_log(LOG_INFO, "computing statistics of %d frames of %dx%d %s.\n",
+             vi.num_frames, vi.width, vi.height, get_string_info(vi.pixel_type));
+
+    int64_t elapsed = get_current_time();
+
+    startPrefetch(0);
+    for (int n = 0; n < vi.num_frames; ++n) {
+        auto frame = getFrame(n);
+        plane_t views[4];
+        for (int p = 0; p < numPlanes; ++p) {
+            views[p] = get_plane(frame, planes[p]);
+        }
+        stats.add(n, views, frame);
+    }
+    prefetcher.reset();
+    stats.finish();
+
+    elapsed = get_current_time() - elapsed;
+    a2pm_log(LOG_INFO, "total elapsed time is %.3f sec.\n", elapsed / 1000000.0);
+}
+
+
 void Avs2PipeMod::outVideo()
 {
     validate(!vi.HasVideo(), "clip has no video.\n");
-    trim();
+    prepareVideoClip();
 
     validate(_setmode(_fileno(stdout), _O_BINARY) == -1,
         "cannot switch stdout to binary mode.\n");
 
-    if (params.format_type == FMT_RAWVIDEO_VFLIP) {
-        invokeFilter("FlipVertical", clip);
-    }
-
     bool y4mout = params.format_type == FMT_YUV4MPEG2;
     std::string msg;
     if (y4mout) {
@@ -417,9 +1099,13 @@ void Avs2PipeMod::outVideo()
         msg += std::format("{:18} sar {}:{}, {} {} video.\n", "", params.sarnum,
             params.sarden, get_string_video_out(vi.pixel_type), type);
     } else {
+        const char* name = prepareRawOut();
         msg = std::format("writing {} frames of {}x{} {} rawvideo.\n",
-             vi.num_frames, vi.width, vi.height,
-            get_string_video_out(vi.pixel_type));
+             vi.num_frames, vi.width, vi.height, name);
+    }
+    if (numFields == 2) {
+        msg += std::format("{:18} each frame is written as two fields, {} first.\n",
+                           "", params.fields == 't' ? "top" : "bottom");
     }
     a2pm_log(LOG_INFO, msg.c_str());
 
@@ -436,86 +1122,217 @@ void Avs2PipeMod::outVideo()
 
     validate(wrote != vi.num_frames,
         std::format("only wrote {} of {} frames.\n", wrote, vi.num_frames));
+
+    if (chunk.count > 0) {
+        chunk_entry_t e;
+        e.file = std::filesystem::path(params.output_path).filename().string();
+        e.index = chunk.index;
+        e.chunks = chunk.count;
+        e.first = chunk.first;
+        e.last = chunk.last;
+        e.format = y4mout ? "y4m" : "raw";
+        e.header = chunk.header;
+        e.bytes = chunk.bytes;
+        e.xxh64 = chunk.hash;
+        e.elapsed = elapsed / 1000000.0;
+        write_chunk_entry(std::format("{}.json", params.output_path).c_str(), e);
+    }
 }
 
 
-template <typename T>
-int Avs2PipeMod::writePixValuesAsText()
+// the planes of -planes, as indices into get_planes().
+std::vector<int> Avs2PipeMod::selectPlanes()
 {
-    const int planes[] = {
-        0,
-        vi.IsYUV() ? PLANAR_U : PLANAR_B,
-        vi.IsYUV() ? PLANAR_V : PLANAR_R,
-        PLANAR_A
-    };
+    std::vector<int> selected;
+    if (!params.planes) {
+        for (int p = 0; p < numPlanes; ++p) {
+            selected.push_back(p);
+        }
+        return selected;
+    }
+    validate(numPlanes == 1 && !vi.IsY(), "-planes needs a planar format.\n");
+    const auto names = get_plane_names(vi, numPlanes);
+    for (const char* c = params.planes; *c; ++c) {
+        auto it = std::find(names.begin(), names.end(), std::string(1, *c));
+        validate(it == names.end(),
+                 std::format("the clip has no plane '{}'.\n", *c));
+        selected.push_back(static_cast<int>(it - names.begin()));
+    }
+    return selected;
+}
 
-    int wrote = 0;
-    while (wrote < vi.num_frames) {
-        auto frame = clip->GetFrame(wrote, env);
-        fprintf(stdout, "frame %d\n", wrote);
 
-        for (int p = 0; p < numPlanes; ++p) {
-            int plane = planes[p];
-            const uint8_t* srcp = frame->GetReadPtr(plane);
-            int width = frame->GetRowSize(plane) / sizeof(T);
-            int height = frame->GetHeight(plane);
-            int pitch = frame->GetPitch(plane);
-
-            if (numPlanes > 1) {
-                if (vi.IsYUV()) {
-                    puts(p == 0 ? "Y-plane" : p == 1 ? "U-plane" : p == 2 ? "V-plane" : "Alpha");
-                } else {
-                    puts(p == 0 ? "G-plane" : p == 1 ? "B-plane" : p == 2 ? "R-plane" : "Alpha");
-                }
-            }
+// -roi is done as -crop, so that setupPlanes() applies it without copying.
+void Avs2PipeMod::setupRoi()
+{
+    if (params.roiwidth == 0) {
+        return;
+    }
+    validate(params.cropleft || params.croptop || params.cropright
+                || params.cropbottom,
+             "-roi and -crop cannot be used together.\n");
+    validate(params.roix + params.roiwidth > vi.width
+                || params.roiy + params.roiheight > vi.height,
+             "-roi is outside of the frame.\n");
+    params.cropleft = params.roix;
+    params.croptop = params.roiy;
+    params.cropright = vi.width - params.roix - params.roiwidth;
+    params.cropbottom = vi.height - params.roiy - params.roiheight;
+}
 
-            for (int y = 0; y < height; ++y) {
-                const T* s0 = reinterpret_cast<const T*>(srcp);
-                for (int x = 0; x < width; ++x) {
-                    if (sizeof(T) != 4) {
-                        fprintf(stdout, "%u\t", static_cast<unsigned>(s0[x]));
-                    } else {
-                        fprintf(stdout, "%.8f\t", static_cast<float>(s0[x]));
-                    }
-                }
-                fputc('\n', stdout);
-                srcp += pitch;
+
+// the planes are formatted on several threads while the next frame is
+// rendered.
+void Avs2PipeMod::dumpPixValues()
+{
+    validate(!vi.HasVideo(), "clip has no video.\n");
+    trim();
+    setupRoi();
+    const auto selected = selectPlanes();
+    const int frames = (vi.num_frames + params.framestep - 1) / params.framestep;
+
+    std::vector<std::string> titles;
+    if (numPlanes > 1) {
+        const char* yuv[] = { "Y-plane", "U-plane", "V-plane", "Alpha" };
+        const char* rgb[] = { "G-plane", "B-plane", "R-plane", "Alpha" };
+        for (int p : selected) {
+            titles.push_back(vi.IsYUV() ? yuv[p] : rgb[p]);
+        }
+    }
+
+    info(false);
+    puts("\n");
+    fflush(stdout);
+
+    setupPlanes();
+    a2pm_log(LOG_INFO,
+             "writing pixel values of %dx%dx%dframes to stdout as text.\n",
+             vi.width, vi.height, frames);
+
+    // with -fields, the planes of both fields follow one frame header.
+    TextDumper dumper(sampleBits, titles);
+    const int num = static_cast<int>(selected.size());
+    int wrote = 0;
+    for (int n = 0; n < vi.num_frames; n += params.framestep) {
+        auto frame = clip->GetFrame(n, env);
+        for (int field = 0; field < numFields; ++field) {
+            plane_t views[4];
+            getPlanes(frame, views, field);
+            for (int i = 0; i < num; ++i) {
+                dumper.add(n, field * num + i, views[selected[i]], frame);
             }
-            fputc('\n', stdout);
         }
         ++wrote;
     }
-    fflush(stdout);
-    return wrote;
+    dumper.finish();
+
+    a2pm_log(LOG_INFO, "finished, wrote %d frames [%d%%].\n",
+             wrote, 100 * wrote / frames);
+
+    validate(wrote != frames, std::format("only wrote {} of {} frames.\n",
+             wrote, frames));
 }
 
 
-void Avs2PipeMod::dumpPixValues()
+// writes the planes as .npy arrays. a path ending in ".npy" is one array of
+// frames x planes x height x width, anything else is a directory of one
+// frames x height x width array per plane. the files are preallocated and
+// written with large sequential unbuffered writes.
+void Avs2PipeMod::dumpNpy()
 {
     validate(!vi.HasVideo(), "clip has no video.\n");
+    validate(numPlanes == 1 && !vi.IsY(), "-dumpnpy needs a planar format.\n");
     trim();
+    setupRoi();
+    const auto selected = selectPlanes();
+    setupPlanes();
+
+    const int frames = (vi.num_frames + params.framestep - 1) / params.framestep;
+    const int64_t entries = static_cast<int64_t>(frames) * numFields;
+    const int bytes = sampleBits == 8 ? 1 : sampleBits == 32 ? 4 : 2;
+    const char* descr = bytes == 1 ? "|u1" : bytes == 4 ? "<f4" : "<u2";
+    const auto names = get_plane_names(vi, numPlanes);
+
+    const std::string path(params.dumpnpy);
+    const bool single = path.size() > 4
+        && path.compare(path.size() - 4, 4, ".npy") == 0;
+
+    // the outputs keep pointers to their paths.
+    std::vector<std::string> paths;
+    std::vector<std::unique_ptr<Output>> outs;
+    auto add = [&](const std::string& name, const std::vector<int64_t>& shape,
+                   uint64_t data_size) {
+        const auto header = npy_header(descr, shape);
+        paths.push_back(name);
+        outs.push_back(create_output(OUT_STDIO, paths.back().c_str(), 0,
+                                     header.size() + data_size));
+        validate(!outs.back()->write(header.data(), header.size()),
+                 std::format("failed to write {}.\n", name));
+    };
 
-    a2pm_log(LOG_INFO,
-             "writing pixel values of %dx%dx%dframes to stdout as text.\n",
-             vi.width, vi.height, vi.num_frames);
+    paths.reserve(selected.size());
+    uint64_t size = 0;
+    if (single) {
+        const auto& first = layout[selected[0]];
+        for (int p : selected) {
+            validate(layout[p].rowsize != first.rowsize
+                        || layout[p].height != first.height,
+                     "planes of different sizes cannot be written to one "
+                     ".npy file. give a directory or select them with -planes.\n");
+        }
+        size = static_cast<uint64_t>(first.rowsize) * first.height
+             * selected.size() * entries;
+        add(path, { entries, static_cast<int64_t>(selected.size()),
+                     first.height, first.rowsize / bytes }, size);
+    } else {
+        std::filesystem::create_directories(path);
+        for (int p : selected) {
+            const auto& l = layout[p];
+            const uint64_t s = static_cast<uint64_t>(l.rowsize) * l.height * entries;
+            add((std::filesystem::path(path) / (names[p] + ".npy")).string(),
+                 { entries, l.height, l.rowsize / bytes }, s);
+            size += s;
+        }
+    }
+    a2pm_log(LOG_INFO, "writing %d frames of %s as %s (%.1f MiB).\n", frames,
+             get_string_info(vi.pixel_type), descr, size / 1048576.0);
 
-    info(false);
-    puts("\n");
+    int64_t elapsed = get_current_time();
 
     int wrote = 0;
-    if (sampleBits == 8) {
-        wrote = writePixValuesAsText<uint8_t>();
-    } else if (sampleBits != 32) {
-        wrote = writePixValuesAsText<uint16_t>();
-    } else {
-        wrote = writePixValuesAsText<float>();
+    bool ok = true;
+    for (int n = 0; n < vi.num_frames && ok; n += params.framestep) {
+        auto frame = clip->GetFrame(n, env);
+        for (int field = 0; field < numFields && ok; ++field) {
+            plane_t views[4], packed[4];
+            getPlanes(frame, views, field);
+            if (single) {
+                for (size_t i = 0; i < selected.size(); ++i) {
+                    packed[i] = views[selected[i]];
+                }
+                ok = outs[0]->writeFrame(nullptr, packed,
+                                         static_cast<int>(selected.size()), frame);
+            } else {
+                for (size_t i = 0; i < selected.size() && ok; ++i) {
+                    ok = outs[i]->writeFrame(nullptr, &views[selected[i]], 1, frame);
+                }
+            }
+        }
+        wrote += ok;
+    }
+    for (size_t i = 0; i < outs.size(); ++i) {
+        validate(!outs[i]->flush(),
+                 std::format("failed to write {}.\n", paths[i]));
     }
+    outs.clear();
 
+    elapsed = get_current_time() - elapsed;
     a2pm_log(LOG_INFO, "finished, wrote %d frames [%d%%].\n",
-             wrote, 100 * wrote / vi.num_frames);
+             wrote, 100 * wrote / frames);
+    a2pm_log(LOG_INFO, "total elapsed time is %.3f sec.\n", elapsed / 1000000.0);
 
-    validate(wrote != vi.num_frames, std::format("only wrote {} of {} frames.\n",
-             wrote, vi.num_frames));
+    validate(wrote != frames, std::format("only wrote {} of {} frames.\n",
+             wrote, frames));
 }
 
 
@@ -537,133 +1354,90 @@ void Avs2PipeMod::dumpPluginFiltersList()
     }
 }
 
-static inline void procIntProp(std::stringstream& ss, const AVSMap* map,
-    ise_t* env, const char* key)
+// the properties are formatted on several threads while the next frames are
+// rendered.
+void Avs2PipeMod::dumpFrameProps()
 {
-    auto elms = env->propNumElements(map, key);
-    if (elms > 1) {
-        ss << "[";
-        for (auto i = 0; i < elms; ++i) {
-            ss << env->propGetInt(map, key, i, nullptr);
-            ss << (i < elms - 1 ? ", " : "]");
-        }
-    } else {
-        ss << env->propGetInt(map, key, 0, nullptr);
-    }
-}
+    validate(version < 3.70, "frame properties does not exists.\n");
+    validate(!vi.HasVideo(), "clip has no video.\n");
+    trim();
 
-static inline void procFloatProp(std::stringstream& ss, const AVSMap* map,
-    ise_t* env, const char* key)
-{
-    auto elms = env->propNumElements(map, key);
-    if (elms > 1) {
-        ss << "[";
-        for (auto i = 0; i < elms; ++i) {
-            ss << std::format("{:.07f}",
-                env->propGetFloat(map, key, i, nullptr))
-                << (i < elms - 1 ? ", " : "]");
+    constexpr int FRAMES_PER_OUT = 100;
+
+    std::unique_ptr<PropsPrinter> printer;
+    std::unique_ptr<PropsColumns> columns;
+    if (params.propsFormat == 'c') {
+        if (!params.output_path) {
+            validate(_setmode(_fileno(stdout), _O_BINARY) == -1,
+                     "cannot switch stdout to binary mode.\n");
         }
+        columns = std::make_unique<PropsColumns>(env, params.props);
     } else {
-        ss << std::format("{:.07f}",
-            env->propGetFloat(map, key, 0, nullptr));
+        printer = std::make_unique<PropsPrinter>(env, params.output_path,
+                                                 params.propsFormat == 'n',
+                                                 params.props, vi.num_frames);
     }
-}
-
+    int64_t elapsed = get_current_time();
 
-static inline void
-setData(std::stringstream& ss,  const AVSMap* map, const char* key, int idx,
-    ise_t* env)
-{
-    auto data = env->propGetData(map, key, idx, nullptr);
-    auto hint = env->propGetDataTypeHint(map, key, idx, nullptr);
-    if (hint == AVSPropDataTypeHint::PROPDATATYPEHINT_BINARY) {
-        auto size = env->propGetDataSize(map, key, idx, nullptr);
-        auto length = std::min(size, 16);
-        std::vector<uint8_t> v(data, data + length);
-        ss << "\"";
-        for (auto j = 0; j < length; ++j) {
-            ss << std::format("{:02x} ", v[j]);
+    startPrefetch(0);
+    int passed = 0;
+    while (passed < vi.num_frames) {
+        auto frame = getFrame(passed);
+        if (columns) {
+            columns->add(env->getFramePropsRO(frame));
+        } else {
+            printer->add(passed, frame);
+        }
+        ++passed;
+        if (passed % FRAMES_PER_OUT == 0 || passed == vi.num_frames) {
+            a2pm_log(LOG_REPEAT, "output %d/%d frame properties.",
+                     passed, vi.num_frames);
         }
-        ss << (length < size ? "...\"" : "\"");
+    }
+    prefetcher.reset();
+    fputs("\n", stderr);
+    if (columns) {
+        columns->write(params.output_path);
     } else {
-        ss << std::format("\"{}\"", data);
+        printer->finish();
     }
-}
 
+    elapsed = get_current_time() - elapsed;
+    a2pm_log(LOG_INFO, "total elapsed time is %.3f sec.\n", elapsed / 1000000.0);
 
-static inline void procDataProp(std::stringstream& ss, const AVSMap* map,
-    ise_t* env, const char* key)
-{
-    auto elms = env->propNumElements(map, key);
-    if (elms > 1) {
-        ss << "[";
-        for (auto i = 0; i < elms; ++i) {
-            setData(ss, map, key, i, env);
-            ss << (i < elms - 1 ? ", " : "]");
-        }
-    } else {
-        setData(ss, map, key, 0, env);
-    }
+    validate(passed != vi.num_frames,
+        std::format("only output {} of {} frame properties.\n", passed,
+            vi.num_frames));
 }
 
 
-void Avs2PipeMod::dumpFrameProps()
+void Avs2PipeMod::propStats()
 {
     validate(version < 3.70, "frame properties does not exists.\n");
     validate(!vi.HasVideo(), "clip has no video.\n");
     trim();
 
-    auto setProp = [](const char* key, const std::stringstream& val,
-        const char* comma, std::stringstream& line) {
-        line << std::format("\"{}\": {}{}", key, val.str(), comma);
-    };
+    constexpr int FRAMES_PER_OUT = 100;
+
+    PropStats stats(env, params.props, params.propStatsDistinct);
+    int64_t elapsed = get_current_time();
 
+    startPrefetch(0);
     int passed = 0;
-    fputs("[\n", stdout);
     while (passed < vi.num_frames) {
-        auto frame = clip->GetFrame(passed++, env);
-        auto map = env->getFramePropsRO(frame);
-        auto num = env->propNumKeys(map);
-
-        std::stringstream line;
-        line << "\t{";
-        for (auto i = 0; i < num; ++i) {
-            auto key = env->propGetKey(map, i);
-            auto t = env->propGetType(map, key);
-            auto comma = i == num - 1 ? "" : ", ";
-            std::stringstream ss;
-            if (t == 'i') {
-                procIntProp(ss, map, env, key);
-                setProp(key, ss, comma, line);
-                continue;
-            }
-            if (t == 'f') {
-                procFloatProp(ss, map, env, key);
-                setProp(key, ss, comma, line);
-                continue;
-            }
-            if (t == 's') {
-                procDataProp(ss, map, env, key);
-                setProp(key, ss, comma, line);
-            }
-        }
-        if (vi.num_frames == passed) {
-            line << "}\n";
-        } else {
-            line << "},\n";
+        auto frame = getFrame(passed++);
+        stats.add(env->getFramePropsRO(frame));
+        if (passed % FRAMES_PER_OUT == 0 || passed == vi.num_frames) {
+            a2pm_log(LOG_REPEAT, "read %d/%d frame properties.",
+                     passed, vi.num_frames);
         }
-        fputs(line.str().c_str(), stdout);
-
-        fprintf(stderr, "\ravs2pipemod[info]: output %d/%d frame properties.",
-            passed, vi.num_frames);
     }
-    fputs("]\n", stdout);
+    prefetcher.reset();
     fputs("\n", stderr);
-    fflush(stdout);
+    stats.print(params.output_path, params.propStatsJson);
 
-    validate(passed != vi.num_frames,
-        std::format("only output {} of {} frame properties.\n", passed,
-            vi.num_frames));
+    elapsed = get_current_time() - elapsed;
+    a2pm_log(LOG_INFO, "total elapsed time is %.3f sec.\n", elapsed / 1000000.0);
 }
 
 
@@ -31,6 +31,9 @@
 #include <avisynth/avisynth.h>
 #endif
 
+#include <memory>
+#include <vector>
+
 #define A2PM_VERSION "1.3.1"
 
 enum action_t {
@@ -42,6 +45,12 @@ enum action_t {
     A2PM_ACT_DUMP_PIXEL_VALUES_AS_TXT,
     A2PM_ACT_DUMP_FRAME_PROPERTIES_AS_JSON,
     A2PM_ACT_FILTERS,
+    A2PM_ACT_CONCAT,
+    A2PM_ACT_FRAMEHASH,
+    A2PM_ACT_COMPARE,
+    A2PM_ACT_STATS,
+    A2PM_ACT_DUMP_NPY,
+    A2PM_ACT_PROPSTATS,
 #if 0
     A2PM_ACT_X264BD,
     A2PM_ACT_X264RAW,
@@ -52,6 +61,14 @@ enum format_type_t{
     FMT_NOTHING = 0,
     FMT_RAWVIDEO,
     FMT_RAWVIDEO_VFLIP,
+    FMT_RAWVIDEO_NV12,
+    FMT_RAWVIDEO_P010,
+    FMT_RAWVIDEO_P016,
+    FMT_RAWVIDEO_V210,
+    FMT_RAWVIDEO_RGB24,
+    FMT_RAWVIDEO_BGR24,
+    FMT_RAWVIDEO_RGB48,
+    FMT_RAWVIDEO_RGBA,
     FMT_YUV4MPEG2,
     FMT_RAWAUDIO,
     FMT_WAVEFORMATEX,
@@ -64,6 +81,25 @@ enum format_type_t{
 #endif
 };
 
+enum output_type_t {
+    OUT_STDIO = 0,
+    OUT_WRITEV,
+    OUT_VMSPLICE,
+};
+
+enum framehash_t {
+    FRAMEHASH_NONE = 0,
+    FRAMEHASH_MD5,
+    FRAMEHASH_CRC32,
+    FRAMEHASH_XXH64,
+};
+
+enum dither_t {
+    DITHER_NONE = 0,
+    DITHER_ORDERED,
+    DITHER_ERRDIFF,
+};
+
 
 struct Params {
     action_t action;
@@ -72,9 +108,23 @@ struct Params {
     int sarden;
     int trimstart;
     int trimend;
+    int cropleft;
+    int croptop;
+    int cropright;
+    int cropbottom;
+    int roix;           // -roi, or roiwidth 0
+    int roiy;
+    int roiwidth;
+    int roiheight;
+    const char* planes;     // letters of the planes of -planes, or nullptr
+    int framestep;
+    const char* dumpnpy;    // the file or directory of -dumpnpy
     char frame_type;
+    char fields;        // 0, 't' or 'b'
+    char fieldbased;    // 'w'eave or 'a'ssume
     char* bit;
     int yuv_depth;
+    dither_t dither;
     const char* dll_path;
     uint32_t channel_mask;
     int colorrange;
@@ -82,16 +132,56 @@ struct Params {
     int transfer;
     int colormatrix;
     int chromaloc;
+    int prefetch;
+    int queue;
+    int workers;
+    int chunk;
+    int chunks;         // -chunks, or 0
+    int chunkSize;      // -chunk-size, or 0
+    int chunkIndex;
+    const char* manifest;   // for -concat
+    const char* frames;     // -frames, or nullptr
+    int resume;             // checkpoint interval of -resume in seconds, or 0
+    framehash_t framehash;
+    const char* framehashPath;  // nullptr for stdout
+    const char* compare;        // the reference script of -compare
+    bool compareJson;
+    bool statsJson;
+    int statsBins;              // bins of the histograms of -stats, or 0
+    char propsFormat;           // 'j'son, 'n'djson or 'c'olumnar
+    const char* props;          // the keys of -props, or nullptr
+    bool propStatsJson;
+    int propStatsDistinct;      // distinct values counted by -propstats
+    const char* benchmarkJson;  // the JSON file of -benchmark, or nullptr
+    output_type_t output;
+    const char* output_path;
+    bool byteswap;
+    bool quiet;                 // no info messages, for -workers and -compare
     Params() : action(A2PM_ACT_NOTHING), format_type(FMT_NOTHING), sarnum(0),
-        sarden(0), trimstart(0), trimend(0), frame_type(0), bit(nullptr),
-        yuv_depth(0), dll_path(nullptr), channel_mask(0),
-        colorrange(-1), colorprim(2), transfer(2), colormatrix(2),
-        chromaloc(-1) { }
+        sarden(0), trimstart(0), trimend(0), cropleft(0), croptop(0),
+        cropright(0), cropbottom(0), roix(0), roiy(0), roiwidth(0),
+        roiheight(0), planes(nullptr), framestep(1), dumpnpy(nullptr),
+        frame_type(0), fields(0), fieldbased('w'), bit(nullptr),
+        yuv_depth(0), dither(DITHER_NONE), dll_path(nullptr),
+        channel_mask(0), colorrange(-1), colorprim(2), transfer(2),
+        colormatrix(2), chromaloc(-1), prefetch(0), queue(0), workers(0),
+        chunk(24), chunks(0), chunkSize(0), chunkIndex(0), manifest(nullptr),
+        frames(nullptr), resume(0), framehash(FRAMEHASH_NONE),
+        framehashPath(nullptr), compare(nullptr), compareJson(false),
+        statsJson(false), statsBins(0), propsFormat('j'), props(nullptr),
+        propStatsJson(false), propStatsDistinct(16),
+        benchmarkJson(nullptr),
+        output(OUT_STDIO), output_path(nullptr), byteswap(false),
+        quiet(false) { }
 };
 
 
 typedef IScriptEnvironment ise_t;
 
+class FramePrefetcher;
+class FrameConverter;
+struct plane_t;
+
 class Avs2PipeMod {
     HMODULE dll;
     Params& params;
@@ -103,12 +193,54 @@ class Avs2PipeMod {
     const char* input;
     int sampleBits;
     int numPlanes;
+    std::unique_ptr<FramePrefetcher> prefetcher;
+    std::unique_ptr<FrameConverter> converter;
+    std::vector<std::unique_ptr<Avs2PipeMod>> workers;
+    Params workerParams;    // the workers change their own copy
+    Params referenceParams; // and so does the reference
+    std::unique_ptr<Avs2PipeMod> reference;     // the clip of -compare
+
+    // the part of each plane that is written, set by setupPlanes().
+    struct plane_layout_t {
+        int plane;
+        int left;       // in bytes
+        int top;        // in rows from the start of the memory
+        int rowsize;
+        int height;
+    } layout[4];
+    int numLayout;
+    bool flip;
+    int numFields;      // 2 if each frame is written as two fields
+    int fieldRow[2];    // first row of each field, in memory order
+
+    // the segment written by -chunks/-chunk-size, set by selectChunk().
+    // the rest is filled in by writeFrames().
+    struct chunk_t {
+        int index;
+        int count;      // 0 if the whole clip is written
+        int first;
+        int last;
+        uint64_t header;
+        uint64_t bytes;
+        uint64_t hash;
+    } chunk;
 
     void invokeFilter(const char* filter, AVSValue args, const char** names=nullptr);
+    void setPixelType(int pixel_type);
     void trim();
+    void selectChunk();
+    void startPrefetch(int first);
+    void startWorkers(int first);
+    PVideoFrame getFrame(int n);
+    void setupPlanes();
+    void getPlanes(const PVideoFrame& frame, plane_t* views, int field);
+    void convertBits(int bits);
+    void prepareVideoClip();
     void prepareY4MOut();
+    const char* prepareRawOut();
     template <bool y4mout> int writeFrames();
-    template <typename T> int writePixValuesAsText();
+    std::vector<int> selectPlanes();
+    void setupRoi();
 public:
     Avs2PipeMod(HMODULE dll, ise_t* env, PClip clip, const char* input, Params& p);
     ~Avs2PipeMod();
@@ -117,8 +249,13 @@ public:
     void outAudio();
     void outVideo();
     void dumpPixValues();
+    void dumpNpy();
     void dumpPluginFiltersList();
     void dumpFrameProps();
+    void propStats();
+    void frameHash();
+    void compare();
+    void stats();
 /*
     void x264bd(Params& params);
     void x264raw(Params& params);
@@ -0,0 +1,958 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include <emmintrin.h>
+#include "convert.h"
+#include "utils.h"
+
+
+/* SSE2 row kernels */
+
+template <typename T>
+static inline __m128 load4_ps(const T* p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i x;
+    if constexpr (sizeof(T) == 1) {
+        x = _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p));
+        x = _mm_unpacklo_epi8(x, zero);
+    } else {
+        x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+    }
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(x, zero));
+}
+
+
+template <typename T>
+static inline void store4_ps(T* p, __m128 x, __m128 maxval)
+{
+    x = _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), maxval);
+    __m128i i = _mm_cvttps_epi32(_mm_add_ps(x, _mm_set1_ps(0.5f)));
+    if constexpr (sizeof(T) == 1) {
+        i = _mm_packs_epi32(i, i);
+        i = _mm_packus_epi16(i, i);
+        *reinterpret_cast<int32_t*>(p) = _mm_cvtsi128_si32(i);
+    } else {
+        // SSE2 has no unsigned saturation from 32 to 16 bits.
+        const __m128i bias = _mm_set1_epi32(0x8000);
+        i = _mm_packs_epi32(_mm_sub_epi32(i, bias), _mm_sub_epi32(i, bias));
+        i = _mm_xor_si128(i, _mm_set1_epi16(-0x8000));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), i);
+    }
+}
+
+
+static inline __m128
+madd3_ps(const float* k, __m128 r, __m128 g, __m128 b)
+{
+    __m128 x = _mm_mul_ps(r, _mm_set1_ps(k[0]));
+    x = _mm_add_ps(x, _mm_mul_ps(g, _mm_set1_ps(k[1])));
+    x = _mm_add_ps(x, _mm_mul_ps(b, _mm_set1_ps(k[2])));
+    return _mm_add_ps(x, _mm_set1_ps(k[3]));
+}
+
+
+template <typename T>
+void rgb_to_yuv_row_sse2(const T* r, const T* g, const T* b, T* y, T* u, T* v,
+                         int width, const rgb_coef_t& c)
+{
+    const __m128 maxval = _mm_set1_ps(c.maxval);
+    const int w4 = width & ~3;
+    for (int x = 0; x < w4; x += 4) {
+        __m128 fr = load4_ps(r + x);
+        __m128 fg = load4_ps(g + x);
+        __m128 fb = load4_ps(b + x);
+        store4_ps(y + x, madd3_ps(c.y, fr, fg, fb), maxval);
+        store4_ps(u + x, madd3_ps(c.u, fr, fg, fb), maxval);
+        store4_ps(v + x, madd3_ps(c.v, fr, fg, fb), maxval);
+    }
+    rgb_to_yuv_row_c(r, g, b, y, u, v, w4, width, c);
+}
+
+template void rgb_to_yuv_row_sse2<uint8_t>(
+    const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, uint8_t*,
+    uint8_t*, int, const rgb_coef_t&);
+template void rgb_to_yuv_row_sse2<uint16_t>(
+    const uint16_t*, const uint16_t*, const uint16_t*, uint16_t*, uint16_t*,
+    uint16_t*, int, const rgb_coef_t&);
+
+
+void yuy2_to_yv16_row_sse2(const uint8_t* src, uint8_t* y, uint8_t* u,
+                           uint8_t* v, int width)
+{
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+    const int w16 = width & ~15;
+    for (int x = 0; x < w16; x += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * x + 16));
+        __m128i luma = _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask));
+        __m128i uv = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(y + x), luma);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(u + x / 2),
+                         _mm_packus_epi16(_mm_and_si128(uv, mask), zero));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(v + x / 2),
+                         _mm_packus_epi16(_mm_srli_epi16(uv, 8), zero));
+    }
+    yuy2_to_yv16_row_c(src, y, u, v, w16, width);
+}
+
+
+template <typename T>
+void upshift_row_sse2(const T* src, uint16_t* dst, int width, int shift)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const int w8 = width & ~7;
+    for (int x = 0; x < w8; x += 8) {
+        __m128i v;
+        if constexpr (sizeof(T) == 1) {
+            v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x));
+            v = _mm_unpacklo_epi8(v, zero);
+        } else {
+            v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_sll_epi16(v, count));
+    }
+    upshift_row_c(src, dst, w8, width, shift);
+}
+
+template void upshift_row_sse2<uint8_t>(const uint8_t*, uint16_t*, int, int);
+template void upshift_row_sse2<uint16_t>(const uint16_t*, uint16_t*, int, int);
+
+
+template <typename T>
+void downshift_row_sse2(const uint16_t* src, T* dst, int width, int shift,
+                        int maxval, const uint16_t* dither)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m128i maxv = _mm_set1_epi16(static_cast<int16_t>(maxval));
+    const int w8 = width & ~7;
+    for (int x = 0; x < w8; x += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither + (x & 15)));
+        v = _mm_srl_epi16(_mm_adds_epu16(v, d), count);
+        // min_epu16 is SSE4.1.
+        v = _mm_sub_epi16(v, _mm_subs_epu16(v, maxv));
+        if constexpr (sizeof(T) == 1) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(v, v));
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), v);
+        }
+    }
+    downshift_row_c(src, dst, w8, width, shift, maxval, dither);
+}
+
+template void downshift_row_sse2<uint8_t>(
+    const uint16_t*, uint8_t*, int, int, int, const uint16_t*);
+template void downshift_row_sse2<uint16_t>(
+    const uint16_t*, uint16_t*, int, int, int, const uint16_t*);
+
+
+template <typename T>
+void float_to_int_row_sse2(const float* src, T* dst, int width, float scale,
+                           float offset, float maxval, const float* dither)
+{
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o = _mm_set1_ps(offset);
+    const __m128 m = _mm_set1_ps(maxval);
+    const int w8 = width & ~7;
+    for (int x = 0; x < w8; x += 8) {
+        __m128i i[2];
+        for (int k = 0; k < 2; ++k) {
+            __m128 v = _mm_mul_ps(_mm_loadu_ps(src + x + 4 * k), s);
+            v = _mm_add_ps(_mm_add_ps(v, o), _mm_loadu_ps(dither + 4 * k));
+            v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), m);
+            i[k] = _mm_cvttps_epi32(v);
+        }
+        if constexpr (sizeof(T) == 1) {
+            __m128i w = _mm_packs_epi32(i[0], i[1]);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(w, w));
+        } else {
+            const __m128i bias = _mm_set1_epi32(0x8000);
+            __m128i w = _mm_packs_epi32(_mm_sub_epi32(i[0], bias), _mm_sub_epi32(i[1], bias));
+            w = _mm_xor_si128(w, _mm_set1_epi16(-0x8000));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), w);
+        }
+    }
+    float_to_int_row_c(src, dst, w8, width, scale, offset, maxval, dither);
+}
+
+template void float_to_int_row_sse2<uint8_t>(
+    const float*, uint8_t*, int, float, float, float, const float*);
+template void float_to_int_row_sse2<uint16_t>(
+    const float*, uint16_t*, int, float, float, float, const float*);
+
+
+template <typename T>
+void interleave_uv_row_sse2(const T* u, const T* v, T* dst, int width,
+                            int shift)
+{
+    constexpr int step = 16 / sizeof(T);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const int w = width & ~(step - 1);
+    for (int x = 0; x < w; x += step) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + x));
+        __m128i lo, hi;
+        if constexpr (sizeof(T) == 1) {
+            lo = _mm_unpacklo_epi8(a, b);
+            hi = _mm_unpackhi_epi8(a, b);
+        } else {
+            a = _mm_sll_epi16(a, count);
+            b = _mm_sll_epi16(b, count);
+            lo = _mm_unpacklo_epi16(a, b);
+            hi = _mm_unpackhi_epi16(a, b);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 2 * x + step), hi);
+    }
+    interleave_uv_row_c(u, v, dst, w, width, shift);
+}
+
+template void interleave_uv_row_sse2<uint8_t>(
+    const uint8_t*, const uint8_t*, uint8_t*, int, int);
+template void interleave_uv_row_sse2<uint16_t>(
+    const uint16_t*, const uint16_t*, uint16_t*, int, int);
+
+
+// rows are 3 samples at lanes 0-2 of r0-r3. returns the first samples of
+// the rows in lanes 0-3 and the second ones in lanes 4-7, and sets 'third'
+// to the third ones in lanes 0-3.
+static inline __m128i
+transpose_4x3_epi16(__m128i r0, __m128i r1, __m128i r2, __m128i r3,
+                    __m128i& third)
+{
+    __m128i t0 = _mm_unpacklo_epi16(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi16(r2, r3);
+    third = _mm_unpackhi_epi32(t0, t1);
+    return _mm_unpacklo_epi32(t0, t1);
+}
+
+
+void v210_pack_row_sse2(const uint16_t* y, const uint16_t* u,
+                        const uint16_t* v, uint32_t* dst, int width)
+{
+    // two groups of 6 pixels make 8 words of a | b << 10 | c << 20.
+    //   a: U0 Y1 V1 Y4 U3 Y7 V4 Y10
+    //   b: Y0 U1 Y3 V2 Y6 U4 Y9 V5
+    //   c: V0 Y2 U2 Y5 V3 Y8 U5 Y11
+    // luma and interleaved chroma are both split into every third sample,
+    // as the columns of 4 rows of 3.
+    const __m128i mask = _mm_set1_epi16(0x3FF);
+    const __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 12 <= width; x += 12) {
+        __m128i y0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + x));
+        __m128i y1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(y + x + 8));
+        __m128i w0 = _mm_unpacklo_epi16(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)));
+        __m128i w1 = _mm_unpacklo_epi16(
+            _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(u + x / 2 + 4)),
+            _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(v + x / 2 + 4)));
+
+        __m128i y2, w2;
+        __m128i y01 = transpose_4x3_epi16(
+            y0, _mm_srli_si128(y0, 6),
+            _mm_or_si128(_mm_srli_si128(y0, 12), _mm_slli_si128(y1, 4)),
+            _mm_srli_si128(y1, 2), y2);
+        __m128i w01 = transpose_4x3_epi16(
+            w0, _mm_srli_si128(w0, 6),
+            _mm_or_si128(_mm_srli_si128(w0, 12), _mm_slli_si128(w1, 4)),
+            _mm_srli_si128(w1, 2), w2);
+
+        __m128i a = _mm_and_si128(_mm_unpacklo_epi16(w01, _mm_srli_si128(y01, 8)), mask);
+        __m128i b = _mm_and_si128(_mm_unpacklo_epi16(y01, w2), mask);
+        __m128i c = _mm_and_si128(_mm_unpacklo_epi16(_mm_srli_si128(w01, 8), y2), mask);
+
+        auto pack = [](__m128i a, __m128i b, __m128i c) {
+            return _mm_or_si128(a, _mm_or_si128(_mm_slli_epi32(b, 10),
+                                                _mm_slli_epi32(c, 20)));
+        };
+        __m128i lo = pack(_mm_unpacklo_epi16(a, zero), _mm_unpacklo_epi16(b, zero),
+                          _mm_unpacklo_epi16(c, zero));
+        __m128i hi = pack(_mm_unpackhi_epi16(a, zero), _mm_unpackhi_epi16(b, zero),
+                          _mm_unpackhi_epi16(c, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x / 6 * 4), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x / 6 * 4 + 4), hi);
+    }
+    v210_pack_row_c(y, u, v, dst, x, width);
+}
+
+
+template <typename T>
+void pack_rgb_row_sse2(const T* c0, const T* c1, const T* c2, const T* c3,
+                       uint8_t* dst, int width, int channels, bool swap)
+{
+    // pixels are built with 4 channels. without pshufb, 3 channels close
+    // the gaps with shifts: first inside each 64bit half for 8bit, then
+    // between the halves. 3 channels stores overlap by 4 bytes.
+    const __m128i lo24 = _mm_set1_epi64x(0x0000000000FFFFFF);
+    const __m128i hi24 = _mm_set1_epi64x(0x0000FFFFFF000000);
+    const __m128i lo48 = _mm_set_epi64x(0, 0x0000FFFFFFFFFFFF);
+    const __m128i hi48 = _mm_set_epi64x(0x00000000FFFFFFFF, 0xFFFF000000000000);
+    const int step = channels == 4 ? 16 : 12;
+    constexpr int n = 16 / sizeof(T);
+    const __m128i zero = _mm_setzero_si128();
+
+    const int w = width & ~(n - 1);
+    for (int x = 0; x < w; x += n) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c0 + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c1 + x));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c2 + x));
+        __m128i d = channels == 4
+            ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(c3 + x)) : zero;
+        __m128i p[4];
+        if constexpr (sizeof(T) == 1) {
+            __m128i ab = _mm_unpacklo_epi8(a, b);
+            __m128i cd = _mm_unpacklo_epi8(c, d);
+            p[0] = _mm_unpacklo_epi16(ab, cd);
+            p[1] = _mm_unpackhi_epi16(ab, cd);
+            ab = _mm_unpackhi_epi8(a, b);
+            cd = _mm_unpackhi_epi8(c, d);
+            p[2] = _mm_unpacklo_epi16(ab, cd);
+            p[3] = _mm_unpackhi_epi16(ab, cd);
+        } else {
+            if (swap) {
+                auto bswap = [](__m128i v) {
+                    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+                };
+                a = bswap(a);
+                b = bswap(b);
+                c = bswap(c);
+                d = bswap(d);
+            }
+            __m128i ab = _mm_unpacklo_epi16(a, b);
+            __m128i cd = _mm_unpacklo_epi16(c, d);
+            p[0] = _mm_unpacklo_epi32(ab, cd);
+            p[1] = _mm_unpackhi_epi32(ab, cd);
+            ab = _mm_unpackhi_epi16(a, b);
+            cd = _mm_unpackhi_epi16(c, d);
+            p[2] = _mm_unpacklo_epi32(ab, cd);
+            p[3] = _mm_unpackhi_epi32(ab, cd);
+        }
+        uint8_t* out = dst + static_cast<size_t>(x) * channels * sizeof(T);
+        for (int k = 0; k < 4; ++k) {
+            __m128i v = p[k];
+            if (channels == 3) {
+                if constexpr (sizeof(T) == 1) {
+                    v = _mm_or_si128(_mm_and_si128(v, lo24),
+                                     _mm_and_si128(_mm_srli_epi64(v, 8), hi24));
+                }
+                v = _mm_or_si128(_mm_and_si128(v, lo48),
+                                 _mm_and_si128(_mm_srli_si128(v, 2), hi48));
+            }
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k * step), v);
+        }
+    }
+    pack_rgb_row_c(c0, c1, c2, c3, dst, w, width, channels, swap);
+}
+
+template void pack_rgb_row_sse2<uint8_t>(
+    const uint8_t*, const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*,
+    int, int, bool);
+template void pack_rgb_row_sse2<uint16_t>(
+    const uint16_t*, const uint16_t*, const uint16_t*, const uint16_t*,
+    uint8_t*, int, int, bool);
+
+
+/* converters */
+
+class Yuy2ToYv16 : public FrameConverter {
+    int width;
+    int height;
+    Buffer buff;
+    decltype(&yuy2_to_yv16_row_sse2) row;
+public:
+    Yuy2ToYv16(const VideoInfo& vi) :
+        width(vi.width), height(vi.height),
+        buff(static_cast<size_t>(vi.width) * vi.height * 2, 64)
+    {
+        row = has_avx2() ? yuy2_to_yv16_row_avx2 : yuy2_to_yv16_row_sse2;
+    }
+
+    int convert(const plane_t* src, plane_t* dst) override
+    {
+        uint8_t* y = reinterpret_cast<uint8_t*>(buff.data());
+        uint8_t* u = y + width * height;
+        uint8_t* v = u + width / 2 * height;
+        const uint8_t* srcp = src[0].ptr;
+        const int pitch = src[0].pitch;
+
+        for (int h = 0; h < height; ++h) {
+            row(srcp, y + h * width, u + h * width / 2, v + h * width / 2, width);
+            srcp += pitch;
+        }
+        dst[0] = { y, width, width, height };
+        dst[1] = { u, width / 2, width / 2, height };
+        dst[2] = { v, width / 2, width / 2, height };
+        return 3;
+    }
+};
+
+
+std::unique_ptr<FrameConverter> create_yuy2_to_yv16(const VideoInfo& vi)
+{
+    return std::make_unique<Yuy2ToYv16>(vi);
+}
+
+
+static rgb_coef_t get_rgb_coef(bool rec709, int bits)
+{
+    const float kr = rec709 ? 0.2126f : 0.299f;
+    const float kb = rec709 ? 0.0722f : 0.114f;
+    const float kg = 1.0f - kr - kb;
+    const float scale = static_cast<float>(1 << (bits - 8));
+    const float maxval = static_cast<float>((1 << bits) - 1);
+    const float ys = 219.0f * scale / maxval;
+    const float cs = 224.0f * scale / maxval;
+    const float cb = 0.5f / (1.0f - kb);
+    const float cr = 0.5f / (1.0f - kr);
+
+    rgb_coef_t c = {
+        { kr * ys, kg * ys, kb * ys, 16.0f * scale },
+        { -kr * cb * cs, -kg * cb * cs, 0.5f * cs, 128.0f * scale },
+        { 0.5f * cs, -kg * cr * cs, -kb * cr * cs, 128.0f * scale },
+        maxval,
+    };
+    return c;
+}
+
+
+template <typename T>
+class RgbToYuv444 : public FrameConverter {
+    typedef void (*row_t)(const T*, const T*, const T*, T*, T*, T*, int,
+                          const rgb_coef_t&);
+    int width;
+    int height;
+    int packed;     // components per pixel of packed RGB, 0 if planar
+    int matrix;
+    rgb_coef_t coef;
+    Buffer buff;
+    Buffer line;
+    row_t row;
+public:
+    RgbToYuv444(const VideoInfo& vi, bool rec709) :
+        width(vi.width), height(vi.height),
+        packed(vi.IsPlanar() ? 0 : vi.IsRGB32() || vi.IsRGB64() ? 4 : 3),
+        matrix(rec709 ? 1 : 6),
+        coef(get_rgb_coef(rec709, vi.BitsPerComponent())),
+        buff(sizeof(T) * vi.width * vi.height * 3, 64),
+        line(sizeof(T) * (vi.width + 16) * 3, 64)
+    {
+        row = has_avx2() ? rgb_to_yuv_row_avx2<T> : rgb_to_yuv_row_sse2<T>;
+    }
+
+    int convert(const plane_t* src, plane_t* dst) override
+    {
+        T* y = reinterpret_cast<T*>(buff.data());
+        T* u = y + width * height;
+        T* v = u + width * height;
+
+        if (packed) {
+            // packed RGB is stored bottom-up as B, G, R(, A).
+            const int pitch = src[0].pitch;
+            const uint8_t* srcp = src[0].ptr + (height - 1) * pitch;
+            T* r = reinterpret_cast<T*>(line.data());
+            T* g = r + width + 16;
+            T* b = g + width + 16;
+            for (int h = 0; h < height; ++h) {
+                const T* s = reinterpret_cast<const T*>(srcp);
+                for (int x = 0; x < width; ++x) {
+                    b[x] = s[x * packed];
+                    g[x] = s[x * packed + 1];
+                    r[x] = s[x * packed + 2];
+                }
+                const int o = h * width;
+                row(r, g, b, y + o, u + o, v + o, width, coef);
+                srcp -= pitch;
+            }
+        } else {
+            // G, B, R
+            const uint8_t* gp = src[0].ptr;
+            const uint8_t* bp = src[1].ptr;
+            const uint8_t* rp = src[2].ptr;
+            for (int h = 0; h < height; ++h) {
+                const int o = h * width;
+                row(reinterpret_cast<const T*>(rp), reinterpret_cast<const T*>(gp),
+                    reinterpret_cast<const T*>(bp), y + o, u + o, v + o, width,
+                    coef);
+                gp += src[0].pitch;
+                bp += src[1].pitch;
+                rp += src[2].pitch;
+            }
+        }
+
+        const int rowsize = width * sizeof(T);
+        dst[0] = { reinterpret_cast<uint8_t*>(y), rowsize, rowsize, height };
+        dst[1] = { reinterpret_cast<uint8_t*>(u), rowsize, rowsize, height };
+        dst[2] = { reinterpret_cast<uint8_t*>(v), rowsize, rowsize, height };
+        return 3;
+    }
+
+    void updateParams(Params& p) override
+    {
+        p.colormatrix = matrix;
+        p.colorrange = 1;
+    }
+};
+
+
+std::unique_ptr<FrameConverter>
+create_rgb_to_yuv444(const VideoInfo& vi, bool rec709)
+{
+    if (!vi.IsRGB() || vi.BitsPerComponent() == 32) {
+        return nullptr;
+    }
+    if (vi.BitsPerComponent() == 8) {
+        return std::make_unique<RgbToYuv444<uint8_t>>(vi, rec709);
+    }
+    return std::make_unique<RgbToYuv444<uint16_t>>(vi, rec709);
+}
+
+
+// planes in the order they are written.
+static const int* get_planes(const VideoInfo& vi)
+{
+    static const int yuv[] = { PLANAR_Y, PLANAR_U, PLANAR_V, PLANAR_A };
+    static const int rgb[] = { PLANAR_G, PLANAR_B, PLANAR_R, PLANAR_A };
+    return vi.IsRGB() ? rgb : yuv;
+}
+
+static const uint8_t bayer8x8[8][8] = {
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+
+// Floyd-Steinberg. cur and next have width + 2 entries, next is cleared
+// by the caller.
+template <typename S, typename D>
+static void
+errdiff_row(const S* src, D* dst, int width, float scale, float offset,
+            float maxval, float* cur, float* next)
+{
+    for (int x = 0; x < width; ++x) {
+        float v = src[x] * scale + offset + cur[x + 1];
+        v = std::min(std::max(v, 0.0f), maxval);
+        float q = static_cast<float>(static_cast<int>(v + 0.5f));
+        float e = v - q;
+        dst[x] = static_cast<D>(q);
+        cur[x + 2] += e * (7.0f / 16);
+        next[x] += e * (3.0f / 16);
+        next[x + 1] += e * (5.0f / 16);
+        next[x + 2] += e * (1.0f / 16);
+    }
+}
+
+
+template <typename S, typename D>
+class DepthConverter : public FrameConverter {
+    std::unique_ptr<FrameConverter> source;
+    int numPlanes;
+    int width[4];
+    int height[4];
+    bool chroma[4];
+    int shift;      // left shift if positive, right shift if negative
+    int maxval;
+    float scale;
+    dither_t dither;
+    uint16_t idither[8][16];
+    float fdither[8][8];
+    Buffer buff;
+    std::vector<float> errors;
+    decltype(&upshift_row_sse2<uint8_t>) up8;
+    decltype(&upshift_row_sse2<uint16_t>) up16;
+    decltype(&downshift_row_sse2<D>) down;
+    decltype(&float_to_int_row_sse2<D>) fconv;
+
+    static size_t frame_size(const VideoInfo& vi)
+    {
+        size_t size = 0;
+        for (int p = 0; p < vi.NumComponents(); ++p) {
+            const int plane = get_planes(vi)[p];
+            size += static_cast<size_t>(vi.width >> vi.GetPlaneWidthSubsampling(plane))
+                * (vi.height >> vi.GetPlaneHeightSubsampling(plane)) * sizeof(D);
+        }
+        return size;
+    }
+
+    void convertPlane(const plane_t& in, D* dstp, int p)
+    {
+        const int w = width[p];
+        const float offset = chroma[p] ? (maxval + 1) / 2.0f : 0.0f;
+        const float fmax = static_cast<float>(maxval);
+        float* cur = errors.data();
+        float* next = cur + w + 2;
+        if (dither == DITHER_ERRDIFF) {
+            std::fill(errors.begin(), errors.end(), 0.0f);
+        }
+
+        const uint8_t* srcp = in.ptr;
+        for (int y = 0; y < height[p]; ++y) {
+            const S* s = reinterpret_cast<const S*>(srcp);
+            D* d = dstp + static_cast<size_t>(y) * w;
+            if constexpr (std::is_same_v<S, float>) {
+                if (dither == DITHER_ERRDIFF) {
+                    errdiff_row(s, d, w, scale, offset, fmax, cur, next);
+                } else {
+                    fconv(s, d, w, scale, offset, fmax, fdither[y & 7]);
+                }
+            } else if (shift > 0) {
+                if constexpr (std::is_same_v<D, uint16_t>) {
+                    if constexpr (sizeof(S) == 1) {
+                        up8(s, d, w, shift);
+                    } else {
+                        up16(s, d, w, shift);
+                    }
+                }
+            } else if constexpr (sizeof(S) == 2) {
+                if (dither == DITHER_ERRDIFF) {
+                    errdiff_row(s, d, w, scale, 0.0f, fmax, cur, next);
+                } else {
+                    down(s, d, w, -shift, maxval, idither[y & 7]);
+                }
+            }
+            if (dither == DITHER_ERRDIFF) {
+                std::swap(cur, next);
+                std::fill(next, next + w + 2, 0.0f);
+            }
+            srcp += in.pitch;
+        }
+    }
+
+public:
+    DepthConverter(const VideoInfo& vi, int bits, dither_t d,
+                   std::unique_ptr<FrameConverter> src) :
+        source(std::move(src)), numPlanes(vi.NumComponents()),
+        shift(bits - vi.BitsPerComponent()), maxval((1 << bits) - 1),
+        scale(1.0f), dither(d), buff(frame_size(vi), 64),
+        errors(d == DITHER_ERRDIFF ? 2 * (vi.width + 2) : 0)
+    {
+        for (int p = 0; p < numPlanes; ++p) {
+            const int plane = get_planes(vi)[p];
+            width[p] = vi.width >> vi.GetPlaneWidthSubsampling(plane);
+            height[p] = vi.height >> vi.GetPlaneHeightSubsampling(plane);
+            chroma[p] = vi.IsYUV() && (p == 1 || p == 2);
+        }
+
+        if constexpr (std::is_same_v<S, float>) {
+            // luma 0.0 - 1.0, chroma -0.5 - 0.5
+            scale = static_cast<float>(maxval);
+        } else if (shift < 0) {
+            scale = 1.0f / (1 << -shift);
+        }
+        // DITHER_NONE rounds to nearest.
+        const int s = shift < 0 ? -shift : 0;
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < 16; ++x) {
+                const int b = bayer8x8[y][x & 7];
+                if (dither == DITHER_ORDERED) {
+                    idither[y][x] = static_cast<uint16_t>(((2 * b + 1) << s) >> 7);
+                } else {
+                    idither[y][x] = static_cast<uint16_t>((1 << s) >> 1);
+                }
+                if (x < 8) {
+                    fdither[y][x] = dither == DITHER_ORDERED ? (b + 0.5f) / 64 : 0.5f;
+                }
+            }
+        }
+
+        const bool avx2 = has_avx2();
+        up8 = avx2 ? upshift_row_avx2<uint8_t> : upshift_row_sse2<uint8_t>;
+        up16 = avx2 ? upshift_row_avx2<uint16_t> : upshift_row_sse2<uint16_t>;
+        down = avx2 ? downshift_row_avx2<D> : downshift_row_sse2<D>;
+        fconv = avx2 ? float_to_int_row_avx2<D> : float_to_int_row_sse2<D>;
+    }
+
+    int convert(const plane_t* src, plane_t* dst) override
+    {
+        plane_t in[4];
+        if (source) {
+            source->convert(src, in);
+            src = in;
+        }
+
+        D* dstp = reinterpret_cast<D*>(buff.data());
+        for (int p = 0; p < numPlanes; ++p) {
+            convertPlane(src[p], dstp, p);
+            const int rowsize = width[p] * sizeof(D);
+            dst[p] = { reinterpret_cast<uint8_t*>(dstp), rowsize, rowsize, height[p] };
+            dstp += static_cast<size_t>(width[p]) * height[p];
+        }
+        return numPlanes;
+    }
+
+    void updateParams(Params& p) override
+    {
+        if (source) {
+            source->updateParams(p);
+        }
+    }
+};
+
+
+std::unique_ptr<FrameConverter>
+create_depth_converter(const VideoInfo& vi, int bits, dither_t dither,
+                       std::unique_ptr<FrameConverter> source)
+{
+    const int src_bits = vi.BitsPerComponent();
+    if (!vi.IsPlanar() || src_bits == bits) {
+        return nullptr;
+    }
+    if (src_bits == 32) {
+        if (bits == 8) {
+            return std::make_unique<DepthConverter<float, uint8_t>>(
+                vi, bits, dither, std::move(source));
+        }
+        return std::make_unique<DepthConverter<float, uint16_t>>(
+            vi, bits, dither, std::move(source));
+    }
+    if (src_bits == 8) {
+        return std::make_unique<DepthConverter<uint8_t, uint16_t>>(
+            vi, bits, dither, std::move(source));
+    }
+    if (bits == 8) {
+        return std::make_unique<DepthConverter<uint16_t, uint8_t>>(
+            vi, bits, dither, std::move(source));
+    }
+    return std::make_unique<DepthConverter<uint16_t, uint16_t>>(
+        vi, bits, dither, std::move(source));
+}
+
+
+template <typename T>
+class SemiPlanar : public FrameConverter {
+    std::unique_ptr<FrameConverter> source;
+    int width;
+    int height;
+    int shift;
+    Buffer buff;
+    decltype(&upshift_row_sse2<uint16_t>) up;
+    decltype(&interleave_uv_row_sse2<T>) interleave;
+public:
+    SemiPlanar(const VideoInfo& vi, int s, std::unique_ptr<FrameConverter> src) :
+        source(std::move(src)), width(vi.width), height(vi.height), shift(s),
+        buff(sizeof(T) * vi.width * vi.height * 3 / 2, 64)
+    {
+        const bool avx2 = has_avx2();
+        up = avx2 ? upshift_row_avx2<uint16_t> : upshift_row_sse2<uint16_t>;
+        interleave = avx2 ? interleave_uv_row_avx2<T> : interleave_uv_row_sse2<T>;
+    }
+
+    int convert(const plane_t* src, plane_t* dst) override
+    {
+        plane_t in[4];
+        if (source) {
+            source->convert(src, in);
+            src = in;
+        }
+
+        T* y = reinterpret_cast<T*>(buff.data());
+        T* uv = y + width * height;
+        const int rowsize = width * sizeof(T);
+
+        // luma goes out as it is unless it has to be shifted.
+        dst[0] = src[0];
+        if constexpr (sizeof(T) == 2) {
+            if (shift > 0) {
+                for (int h = 0; h < height; ++h) {
+                    up(reinterpret_cast<const uint16_t*>(src[0].ptr + h * src[0].pitch),
+                       y + h * width, width, shift);
+                }
+                dst[0] = { reinterpret_cast<uint8_t*>(y), rowsize, rowsize, height };
+            }
+        }
+
+        for (int h = 0; h < height / 2; ++h) {
+            interleave(reinterpret_cast<const T*>(src[1].ptr + h * src[1].pitch),
+                       reinterpret_cast<const T*>(src[2].ptr + h * src[2].pitch),
+                       uv + h * width, width / 2, shift);
+        }
+        dst[1] = { reinterpret_cast<uint8_t*>(uv), rowsize, rowsize, height / 2 };
+        return 2;
+    }
+
+    void updateParams(Params& p) override
+    {
+        if (source) {
+            source->updateParams(p);
+        }
+    }
+};
+
+
+std::unique_ptr<FrameConverter>
+create_semiplanar(const VideoInfo& vi, int shift,
+                  std::unique_ptr<FrameConverter> source)
+{
+    if (!vi.Is420() || vi.BitsPerComponent() == 32) {
+        return nullptr;
+    }
+    if (vi.BitsPerComponent() == 8) {
+        return std::make_unique<SemiPlanar<uint8_t>>(vi, 0, std::move(source));
+    }
+    return std::make_unique<SemiPlanar<uint16_t>>(vi, shift, std::move(source));
+}
+
+
+class V210 : public FrameConverter {
+    std::unique_ptr<FrameConverter> source;
+    int width;
+    int height;
+    int lineSize;
+    Buffer buff;
+    decltype(&v210_pack_row_avx2) pack;
+public:
+    V210(const VideoInfo& vi, std::unique_ptr<FrameConverter> src) :
+        source(std::move(src)), width(vi.width), height(vi.height),
+        lineSize(v210_line_size(vi.width)),
+        buff(static_cast<size_t>(lineSize) * vi.height, 64)
+    {
+        // the gaps between the groups and the line end stay zero.
+        memset(buff.data(), 0, static_cast<size_t>(lineSize) * height);
+        pack = has_avx2() ? v210_pack_row_avx2 : v210_pack_row_sse2;
+    }
+
+    int convert(const plane_t* src, plane_t* dst) override
+    {
+        plane_t in[4];
+        if (source) {
+            source->convert(src, in);
+            src = in;
+        }
+
+        uint8_t* dstp = reinterpret_cast<uint8_t*>(buff.data());
+        for (int h = 0; h < height; ++h) {
+            pack(reinterpret_cast<const uint16_t*>(src[0].ptr + h * src[0].pitch),
+                 reinterpret_cast<const uint16_t*>(src[1].ptr + h * src[1].pitch),
+                 reinterpret_cast<const uint16_t*>(src[2].ptr + h * src[2].pitch),
+                 reinterpret_cast<uint32_t*>(dstp + h * lineSize), width);
+        }
+        dst[0] = { dstp, lineSize, lineSize, height };
+        return 1;
+    }
+
+    void updateParams(Params& p) override
+    {
+        if (source) {
+            source->updateParams(p);
+        }
+    }
+};
+
+
+std::unique_ptr<FrameConverter>
+create_v210(const VideoInfo& vi, std::unique_ptr<FrameConverter> source)
+{
+    if (!vi.Is422() || vi.BitsPerComponent() != 10) {
+        return nullptr;
+    }
+    return std::make_unique<V210>(vi, std::move(source));
+}
+
+
+template <typename T>
+class RgbPacker : public FrameConverter {
+    typedef void (*row_t)(const T*, const T*, const T*, const T*, uint8_t*,
+                          int, int, bool);
+    std::unique_ptr<FrameConverter> source;
+    int width;
+    int height;
+    bool bgr;
+    int channels;
+    bool alpha;     // the clip has an alpha plane
+    bool swap;
+    Buffer buff;
+    std::vector<T> opaque;
+    row_t pack;
+public:
+    RgbPacker(const VideoInfo& vi, bool b, int c, bool s,
+              std::unique_ptr<FrameConverter> src) :
+        source(std::move(src)), width(vi.width), height(vi.height), bgr(b),
+        channels(c), alpha(vi.NumComponents() == 4), swap(s),
+        buff(sizeof(T) * vi.width * vi.height * c + 16, 64),
+        opaque(vi.width, static_cast<T>((1 << vi.BitsPerComponent()) - 1))
+    {
+        pack = has_avx2() ? pack_rgb_row_avx2<T> : pack_rgb_row_sse2<T>;
+    }
+
+    int convert(const plane_t* src, plane_t* dst) override
+    {
+        plane_t in[4];
+        if (source) {
+            source->convert(src, in);
+            src = in;
+        }
+
+        // G, B, R(, A)
+        const int first = bgr ? 1 : 2;
+        const int last = bgr ? 2 : 1;
+        const int rowsize = width * channels * sizeof(T);
+        uint8_t* dstp = reinterpret_cast<uint8_t*>(buff.data());
+        for (int h = 0; h < height; ++h) {
+            auto row = [src, h](int p) {
+                return reinterpret_cast<const T*>(src[p].ptr + h * src[p].pitch);
+            };
+            pack(row(first), row(0), row(last), alpha ? row(3) : opaque.data(),
+                 dstp + h * rowsize, width, channels, swap);
+        }
+        dst[0] = { dstp, rowsize, rowsize, height };
+        return 1;
+    }
+
+    void updateParams(Params& p) override
+    {
+        if (source) {
+            source->updateParams(p);
+        }
+    }
+};
+
+
+std::unique_ptr<FrameConverter>
+create_rgb_packer(const VideoInfo& vi, bool bgr, int channels, bool swap,
+                  std::unique_ptr<FrameConverter> source)
+{
+    if (!vi.IsPlanarRGB() && !vi.IsPlanarRGBA()) {
+        return nullptr;
+    }
+    if (vi.BitsPerComponent() == 8) {
+        return std::make_unique<RgbPacker<uint8_t>>(vi, bgr, channels, swap,
+                                                    std::move(source));
+    }
+    if (vi.BitsPerComponent() == 16) {
+        return std::make_unique<RgbPacker<uint16_t>>(vi, bgr, channels, swap,
+                                                     std::move(source));
+    }
+    return nullptr;
+}
@@ -0,0 +1,256 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#ifndef A2PM_CONVERT_H
+#define A2PM_CONVERT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include "avs2pipemod.h"
+#include "output.h"
+
+
+// converts a frame into the planes to be written, inside the output loop.
+class FrameConverter {
+public:
+    virtual ~FrameConverter() {}
+    // src are the planes of the frame as they are written without
+    // conversion. dst receives views of the converted planes. they stay
+    // valid until the next call. returns the number of planes.
+    virtual int convert(const plane_t* src, plane_t* dst) = 0;
+    // overrides stream properties that the conversion has changed.
+    virtual void updateParams(Params&) {}
+};
+
+
+// YUY2 -> YV16.
+std::unique_ptr<FrameConverter> create_yuy2_to_yv16(const VideoInfo& vi);
+
+// packed/planar RGB -> YUV444 of the same bit depth, limited range.
+// returns nullptr if the format is not supported.
+std::unique_ptr<FrameConverter>
+create_rgb_to_yuv444(const VideoInfo& vi, bool rec709);
+
+// planar YUV/Y/RGB of any bit depth -> 'bits' bits integer. vi describes the
+// output of 'source', or the clip itself if 'source' is nullptr.
+// returns nullptr if the format is not supported.
+std::unique_ptr<FrameConverter>
+create_depth_converter(const VideoInfo& vi, int bits, dither_t dither,
+                       std::unique_ptr<FrameConverter> source);
+
+// YUV420 -> NV12 style semi-planar, with samples shifted left by 'shift'
+// bits. vi and source as above.
+std::unique_ptr<FrameConverter>
+create_semiplanar(const VideoInfo& vi, int shift,
+                  std::unique_ptr<FrameConverter> source);
+
+// YUV422P10 -> v210. vi and source as above.
+std::unique_ptr<FrameConverter>
+create_v210(const VideoInfo& vi, std::unique_ptr<FrameConverter> source);
+
+// planar RGB(A) -> packed R, G, B(, A) or B, G, R. alpha is opaque if the
+// clip has none. swap reverses the bytes of 16bit samples. vi and source
+// as above.
+std::unique_ptr<FrameConverter>
+create_rgb_packer(const VideoInfo& vi, bool bgr, int channels, bool swap,
+                  std::unique_ptr<FrameConverter> source);
+
+// bytes of a v210 line, padded to 48 pixels / 128 bytes.
+static inline int v210_line_size(int width)
+{
+    return (width + 47) / 48 * 128;
+}
+
+
+/* row kernels */
+
+struct rgb_coef_t {
+    float y[4];     // r, g, b, offset
+    float u[4];
+    float v[4];
+    float maxval;
+};
+
+template <typename T>
+static inline void
+rgb_to_yuv_row_c(const T* r, const T* g, const T* b, T* y, T* u, T* v,
+                 int start, int width, const rgb_coef_t& c)
+{
+    auto conv = [&c](const float* k, float r, float g, float b) {
+        float x = k[0] * r + k[1] * g + k[2] * b + k[3];
+        return static_cast<T>(std::min(std::max(x, 0.0f), c.maxval) + 0.5f);
+    };
+    for (int x = start; x < width; ++x) {
+        float fr = r[x], fg = g[x], fb = b[x];
+        y[x] = conv(c.y, fr, fg, fb);
+        u[x] = conv(c.u, fr, fg, fb);
+        v[x] = conv(c.v, fr, fg, fb);
+    }
+}
+
+static inline void
+yuy2_to_yv16_row_c(const uint8_t* src, uint8_t* y, uint8_t* u, uint8_t* v,
+                   int start, int width)
+{
+    for (int x = start; x < width; x += 2) {
+        y[x] = src[2 * x];
+        u[x / 2] = src[2 * x + 1];
+        y[x + 1] = src[2 * x + 2];
+        v[x / 2] = src[2 * x + 3];
+    }
+}
+
+// integer -> wider integer.
+template <typename T>
+static inline void
+upshift_row_c(const T* src, uint16_t* dst, int start, int width, int shift)
+{
+    for (int x = start; x < width; ++x) {
+        dst[x] = static_cast<uint16_t>(src[x] << shift);
+    }
+}
+
+// integer -> narrower integer. dither holds 16 values added before the
+// shift, repeating every 8 pixels.
+template <typename T>
+static inline void
+downshift_row_c(const uint16_t* src, T* dst, int start, int width, int shift,
+                int maxval, const uint16_t* dither)
+{
+    for (int x = start; x < width; ++x) {
+        int v = (src[x] + dither[x & 15]) >> shift;
+        dst[x] = static_cast<T>(std::min(v, maxval));
+    }
+}
+
+// float -> integer. dither holds 8 values in [0, 1) added before truncation.
+template <typename T>
+static inline void
+float_to_int_row_c(const float* src, T* dst, int start, int width,
+                   float scale, float offset, float maxval, const float* dither)
+{
+    for (int x = start; x < width; ++x) {
+        float v = src[x] * scale + offset + dither[x & 7];
+        dst[x] = static_cast<T>(std::min(std::max(v, 0.0f), maxval));
+    }
+}
+
+template <typename T>
+static inline void
+interleave_uv_row_c(const T* u, const T* v, T* dst, int start, int width,
+                    int shift)
+{
+    for (int x = start; x < width; ++x) {
+        dst[2 * x] = static_cast<T>(u[x] << shift);
+        dst[2 * x + 1] = static_cast<T>(v[x] << shift);
+    }
+}
+
+// packs groups of 6 pixels into 4 little endian words. start is a multiple
+// of 6, samples beyond width are zero.
+static inline void
+v210_pack_row_c(const uint16_t* y, const uint16_t* u, const uint16_t* v,
+                uint32_t* dst, int start, int width)
+{
+    const int cw = (width + 1) / 2;
+    auto y_ = [y, width](int x) -> uint32_t { return x < width ? y[x] & 0x3FF : 0; };
+    auto u_ = [u, cw](int x) -> uint32_t { return x < cw ? u[x] & 0x3FF : 0; };
+    auto v_ = [v, cw](int x) -> uint32_t { return x < cw ? v[x] & 0x3FF : 0; };
+    dst += start / 6 * 4;
+    for (int x = start; x < width; x += 6) {
+        const int c = x / 2;
+        dst[0] = u_(c) | y_(x) << 10 | v_(c) << 20;
+        dst[1] = y_(x + 1) | u_(c + 1) << 10 | y_(x + 2) << 20;
+        dst[2] = v_(c + 1) | y_(x + 3) << 10 | u_(c + 2) << 20;
+        dst[3] = y_(x + 4) | v_(c + 2) << 10 | y_(x + 5) << 20;
+        dst += 4;
+    }
+}
+
+// interleaves c0, c1, c2(, c3) into pixels of 'channels' samples.
+template <typename T>
+static inline void
+pack_rgb_row_c(const T* c0, const T* c1, const T* c2, const T* c3,
+               uint8_t* dst, int start, int width, int channels, bool swap)
+{
+    T* d = reinterpret_cast<T*>(dst) + start * channels;
+    for (int x = start; x < width; ++x) {
+        T px[4] = { c0[x], c1[x], c2[x], channels == 4 ? c3[x] : T() };
+        for (int c = 0; c < channels; ++c) {
+            T v = px[c];
+            if constexpr (sizeof(T) == 2) {
+                if (swap) {
+                    v = static_cast<T>(v << 8 | v >> 8);
+                }
+            }
+            *d++ = v;
+        }
+    }
+}
+
+template <typename T>
+void rgb_to_yuv_row_sse2(const T* r, const T* g, const T* b, T* y, T* u, T* v,
+                         int width, const rgb_coef_t& c);
+template <typename T>
+void rgb_to_yuv_row_avx2(const T* r, const T* g, const T* b, T* y, T* u, T* v,
+                         int width, const rgb_coef_t& c);
+
+void yuy2_to_yv16_row_sse2(const uint8_t* src, uint8_t* y, uint8_t* u,
+                           uint8_t* v, int width);
+void yuy2_to_yv16_row_avx2(const uint8_t* src, uint8_t* y, uint8_t* u,
+                           uint8_t* v, int width);
+
+template <typename T>
+void upshift_row_sse2(const T* src, uint16_t* dst, int width, int shift);
+template <typename T>
+void upshift_row_avx2(const T* src, uint16_t* dst, int width, int shift);
+template <typename T>
+void downshift_row_sse2(const uint16_t* src, T* dst, int width, int shift,
+                        int maxval, const uint16_t* dither);
+template <typename T>
+void downshift_row_avx2(const uint16_t* src, T* dst, int width, int shift,
+                        int maxval, const uint16_t* dither);
+template <typename T>
+void float_to_int_row_sse2(const float* src, T* dst, int width, float scale,
+                           float offset, float maxval, const float* dither);
+template <typename T>
+void float_to_int_row_avx2(const float* src, T* dst, int width, float scale,
+                           float offset, float maxval, const float* dither);
+template <typename T>
+void interleave_uv_row_sse2(const T* u, const T* v, T* dst, int width,
+                            int shift);
+template <typename T>
+void interleave_uv_row_avx2(const T* u, const T* v, T* dst, int width,
+                            int shift);
+void v210_pack_row_sse2(const uint16_t* y, const uint16_t* u,
+                        const uint16_t* v, uint32_t* dst, int width);
+void v210_pack_row_avx2(const uint16_t* y, const uint16_t* u,
+                        const uint16_t* v, uint32_t* dst, int width);
+// these write up to 4 bytes past the end of the row for 3 channels.
+template <typename T>
+void pack_rgb_row_sse2(const T* c0, const T* c1, const T* c2, const T* c3,
+                       uint8_t* dst, int width, int channels, bool swap);
+template <typename T>
+void pack_rgb_row_avx2(const T* c0, const T* c1, const T* c2, const T* c3,
+                       uint8_t* dst, int width, int channels, bool swap);
+
+#endif
@@ -0,0 +1,344 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <immintrin.h>
+#include "convert.h"
+
+
+template <typename T>
+static inline __m256 load8_ps(const T* p)
+{
+    __m256i x;
+    if constexpr (sizeof(T) == 1) {
+        x = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    } else {
+        x = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+    return _mm256_cvtepi32_ps(x);
+}
+
+
+template <typename T>
+static inline void store8_ps(T* p, __m256 x, __m256 maxval)
+{
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()), maxval);
+    __m256i i = _mm256_cvttps_epi32(_mm256_add_ps(x, _mm256_set1_ps(0.5f)));
+    __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i),
+                                 _mm256_extracti128_si256(i, 1));
+    if constexpr (sizeof(T) == 1) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_packus_epi16(w, w));
+    } else {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), w);
+    }
+}
+
+
+static inline __m256
+madd3_ps(const float* k, __m256 r, __m256 g, __m256 b)
+{
+    __m256 x = _mm256_mul_ps(r, _mm256_set1_ps(k[0]));
+    // no FMA, results have to match the SSE2 and C versions.
+    x = _mm256_add_ps(x, _mm256_mul_ps(g, _mm256_set1_ps(k[1])));
+    x = _mm256_add_ps(x, _mm256_mul_ps(b, _mm256_set1_ps(k[2])));
+    return _mm256_add_ps(x, _mm256_set1_ps(k[3]));
+}
+
+
+template <typename T>
+void rgb_to_yuv_row_avx2(const T* r, const T* g, const T* b, T* y, T* u, T* v,
+                         int width, const rgb_coef_t& c)
+{
+    const __m256 maxval = _mm256_set1_ps(c.maxval);
+    const int w8 = width & ~7;
+    for (int x = 0; x < w8; x += 8) {
+        __m256 fr = load8_ps(r + x);
+        __m256 fg = load8_ps(g + x);
+        __m256 fb = load8_ps(b + x);
+        store8_ps(y + x, madd3_ps(c.y, fr, fg, fb), maxval);
+        store8_ps(u + x, madd3_ps(c.u, fr, fg, fb), maxval);
+        store8_ps(v + x, madd3_ps(c.v, fr, fg, fb), maxval);
+    }
+    rgb_to_yuv_row_c(r, g, b, y, u, v, w8, width, c);
+}
+
+template void rgb_to_yuv_row_avx2<uint8_t>(
+    const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*, uint8_t*,
+    uint8_t*, int, const rgb_coef_t&);
+template void rgb_to_yuv_row_avx2<uint16_t>(
+    const uint16_t*, const uint16_t*, const uint16_t*, uint16_t*, uint16_t*,
+    uint16_t*, int, const rgb_coef_t&);
+
+
+void yuy2_to_yv16_row_avx2(const uint8_t* src, uint8_t* y, uint8_t* u,
+                           uint8_t* v, int width)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+    const int w32 = width & ~31;
+    for (int x = 0; x < w32; x += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * x + 32));
+        // packus works within 128bit lanes, permute restores the order.
+        __m256i luma = _mm256_packus_epi16(_mm256_and_si256(a, mask),
+                                           _mm256_and_si256(b, mask));
+        __m256i uv = _mm256_packus_epi16(_mm256_srli_epi16(a, 8),
+                                         _mm256_srli_epi16(b, 8));
+        luma = _mm256_permute4x64_epi64(luma, 0xD8);
+        uv = _mm256_permute4x64_epi64(uv, 0xD8);
+        __m256i cb = _mm256_packus_epi16(_mm256_and_si256(uv, mask), uv);
+        __m256i cr = _mm256_packus_epi16(_mm256_srli_epi16(uv, 8), uv);
+        cb = _mm256_permute4x64_epi64(cb, 0xD8);
+        cr = _mm256_permute4x64_epi64(cr, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + x), luma);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(u + x / 2), _mm256_castsi256_si128(cb));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x / 2), _mm256_castsi256_si128(cr));
+    }
+    yuy2_to_yv16_row_c(src, y, u, v, w32, width);
+}
+
+
+template <typename T>
+void upshift_row_avx2(const T* src, uint16_t* dst, int width, int shift)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const int w16 = width & ~15;
+    for (int x = 0; x < w16; x += 16) {
+        __m256i v;
+        if constexpr (sizeof(T) == 1) {
+            v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)));
+        } else {
+            v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_sll_epi16(v, count));
+    }
+    upshift_row_c(src, dst, w16, width, shift);
+}
+
+template void upshift_row_avx2<uint8_t>(const uint8_t*, uint16_t*, int, int);
+template void upshift_row_avx2<uint16_t>(const uint16_t*, uint16_t*, int, int);
+
+
+template <typename T>
+void downshift_row_avx2(const uint16_t* src, T* dst, int width, int shift,
+                        int maxval, const uint16_t* dither)
+{
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const __m256i maxv = _mm256_set1_epi16(static_cast<int16_t>(maxval));
+    const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither));
+    const int w16 = width & ~15;
+    for (int x = 0; x < w16; x += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+        v = _mm256_srl_epi16(_mm256_adds_epu16(v, d), count);
+        v = _mm256_min_epu16(v, maxv);
+        if constexpr (sizeof(T) == 1) {
+            __m128i b = _mm_packus_epi16(_mm256_castsi256_si128(v),
+                                         _mm256_extracti128_si256(v, 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), b);
+        } else {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), v);
+        }
+    }
+    downshift_row_c(src, dst, w16, width, shift, maxval, dither);
+}
+
+template void downshift_row_avx2<uint8_t>(
+    const uint16_t*, uint8_t*, int, int, int, const uint16_t*);
+template void downshift_row_avx2<uint16_t>(
+    const uint16_t*, uint16_t*, int, int, int, const uint16_t*);
+
+
+template <typename T>
+void float_to_int_row_avx2(const float* src, T* dst, int width, float scale,
+                           float offset, float maxval, const float* dither)
+{
+    const __m256 s = _mm256_set1_ps(scale);
+    const __m256 o = _mm256_set1_ps(offset);
+    const __m256 m = _mm256_set1_ps(maxval);
+    const __m256 d = _mm256_loadu_ps(dither);
+    const int w8 = width & ~7;
+    for (int x = 0; x < w8; x += 8) {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src + x), s);
+        v = _mm256_add_ps(_mm256_add_ps(v, o), d);
+        v = _mm256_min_ps(_mm256_max_ps(v, _mm256_setzero_ps()), m);
+        __m256i i = _mm256_cvttps_epi32(v);
+        __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(i),
+                                     _mm256_extracti128_si256(i, 1));
+        if constexpr (sizeof(T) == 1) {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(w, w));
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), w);
+        }
+    }
+    float_to_int_row_c(src, dst, w8, width, scale, offset, maxval, dither);
+}
+
+template void float_to_int_row_avx2<uint8_t>(
+    const float*, uint8_t*, int, float, float, float, const float*);
+template void float_to_int_row_avx2<uint16_t>(
+    const float*, uint16_t*, int, float, float, float, const float*);
+
+
+template <typename T>
+void interleave_uv_row_avx2(const T* u, const T* v, T* dst, int width,
+                            int shift)
+{
+    constexpr int step = 32 / sizeof(T);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    const int w = width & ~(step - 1);
+    for (int x = 0; x < w; x += step) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + x));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + x));
+        __m256i lo, hi;
+        if constexpr (sizeof(T) == 1) {
+            lo = _mm256_unpacklo_epi8(a, b);
+            hi = _mm256_unpackhi_epi8(a, b);
+        } else {
+            a = _mm256_sll_epi16(a, count);
+            b = _mm256_sll_epi16(b, count);
+            lo = _mm256_unpacklo_epi16(a, b);
+            hi = _mm256_unpackhi_epi16(a, b);
+        }
+        // unpack works within 128bit lanes.
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * x),
+                            _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 2 * x + step),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave_uv_row_c(u, v, dst, w, width, shift);
+}
+
+template void interleave_uv_row_avx2<uint8_t>(
+    const uint8_t*, const uint8_t*, uint8_t*, int, int);
+template void interleave_uv_row_avx2<uint16_t>(
+    const uint16_t*, const uint16_t*, uint16_t*, int, int);
+
+
+void v210_pack_row_avx2(const uint16_t* y, const uint16_t* u,
+                        const uint16_t* v, uint32_t* dst, int width)
+{
+    // each 128bit lane makes one group of 6 pixels. the words take
+    // a | b << 10 | c << 20 from 16bit samples of Y (lo) and U0-3 V0-3 (hi).
+    //   word0: U0 Y0 V0  word1: Y1 U1 Y2  word2: V1 Y3 U2  word3: Y4 V2 Y5
+    const __m256i ya = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, -1, -1, 8, 9, -1, -1));
+    const __m256i ca = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        0, 1, -1, -1, -1, -1, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1));
+    const __m256i yb = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        0, 1, -1, -1, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, -1, -1));
+    const __m256i cb = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        -1, -1, -1, -1, 2, 3, -1, -1, -1, -1, -1, -1, 12, 13, -1, -1));
+    const __m256i yc = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, -1, -1, 10, 11, -1, -1));
+    const __m256i cc = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+        8, 9, -1, -1, -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, -1, -1));
+    const __m256i mask = _mm256_set1_epi32(0x3FF);
+
+    // loads reach 2 luma / 1 chroma samples past the groups.
+    int x = 0;
+    for (; x + 14 <= width; x += 12) {
+        __m256i luma = _mm256_loadu2_m128i(
+            reinterpret_cast<const __m128i*>(y + x + 6),
+            reinterpret_cast<const __m128i*>(y + x));
+        __m128i c0 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2)),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2)));
+        __m128i c1 = _mm_unpacklo_epi64(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u + x / 2 + 3)),
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v + x / 2 + 3)));
+        __m256i chroma = _mm256_set_m128i(c1, c0);
+
+        __m256i a = _mm256_or_si256(_mm256_shuffle_epi8(luma, ya),
+                                    _mm256_shuffle_epi8(chroma, ca));
+        __m256i b = _mm256_or_si256(_mm256_shuffle_epi8(luma, yb),
+                                    _mm256_shuffle_epi8(chroma, cb));
+        __m256i c = _mm256_or_si256(_mm256_shuffle_epi8(luma, yc),
+                                    _mm256_shuffle_epi8(chroma, cc));
+        a = _mm256_and_si256(a, mask);
+        b = _mm256_slli_epi32(_mm256_and_si256(b, mask), 10);
+        c = _mm256_slli_epi32(_mm256_and_si256(c, mask), 20);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x / 6 * 4),
+                            _mm256_or_si256(a, _mm256_or_si256(b, c)));
+    }
+    v210_pack_row_c(y, u, v, dst, x, width);
+}
+
+
+template <typename T>
+void pack_rgb_row_avx2(const T* c0, const T* c1, const T* c2, const T* c3,
+                       uint8_t* dst, int width, int channels, bool swap)
+{
+    // pixels are built with 4 channels, and 3 channels drop the 4th sample
+    // of each pixel by a shuffle. 3 channels stores overlap by 4 bytes.
+    __m128i mask;
+    if constexpr (sizeof(T) == 1) {
+        mask = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    } else if (channels == 3) {
+        mask = swap ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 9, 8, 11, 10, 13, 12, -1, -1, -1, -1)
+                    : _mm_setr_epi8(0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1);
+    } else {
+        mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    }
+    const bool shuffle = channels == 3 || (sizeof(T) == 2 && swap);
+    const int step = channels == 4 ? 16 : 12;
+    constexpr int n = 16 / sizeof(T);
+    const __m128i zero = _mm_setzero_si128();
+
+    const int w = width & ~(n - 1);
+    for (int x = 0; x < w; x += n) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c0 + x));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c1 + x));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c2 + x));
+        __m128i d = channels == 4
+            ? _mm_loadu_si128(reinterpret_cast<const __m128i*>(c3 + x)) : zero;
+        __m128i p[4];
+        if constexpr (sizeof(T) == 1) {
+            __m128i ab = _mm_unpacklo_epi8(a, b);
+            __m128i cd = _mm_unpacklo_epi8(c, d);
+            p[0] = _mm_unpacklo_epi16(ab, cd);
+            p[1] = _mm_unpackhi_epi16(ab, cd);
+            ab = _mm_unpackhi_epi8(a, b);
+            cd = _mm_unpackhi_epi8(c, d);
+            p[2] = _mm_unpacklo_epi16(ab, cd);
+            p[3] = _mm_unpackhi_epi16(ab, cd);
+        } else {
+            __m128i ab = _mm_unpacklo_epi16(a, b);
+            __m128i cd = _mm_unpacklo_epi16(c, d);
+            p[0] = _mm_unpacklo_epi32(ab, cd);
+            p[1] = _mm_unpackhi_epi32(ab, cd);
+            ab = _mm_unpackhi_epi16(a, b);
+            cd = _mm_unpackhi_epi16(c, d);
+            p[2] = _mm_unpacklo_epi32(ab, cd);
+            p[3] = _mm_unpackhi_epi32(ab, cd);
+        }
+        uint8_t* out = dst + static_cast<size_t>(x) * channels * sizeof(T);
+        for (int k = 0; k < 4; ++k) {
+            __m128i v = shuffle ? _mm_shuffle_epi8(p[k], mask) : p[k];
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + k * step), v);
+        }
+    }
+    pack_rgb_row_c(c0, c1, c2, c3, dst, w, width, channels, swap);
+}
+
+template void pack_rgb_row_avx2<uint8_t>(
+    const uint8_t*, const uint8_t*, const uint8_t*, const uint8_t*, uint8_t*,
+    int, int, bool);
+template void pack_rgb_row_avx2<uint16_t>(
+    const uint16_t*, const uint16_t*, const uint16_t*, const uint16_t*,
+    uint8_t*, int, int, bool);
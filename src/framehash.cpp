@@ -0,0 +1,177 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <format>
+#include <numeric>
+#include "framehash.h"
+#include "hash.h"
+#include "utils.h"
+
+
+template <typename H>
+static void hash_planes(H& h, const std::vector<plane_t>& planes)
+{
+    for (const auto& pl : planes) {
+        const uint8_t* srcp = pl.ptr;
+        for (int y = 0; y < pl.height; ++y) {
+            h.update(srcp, pl.rowsize);
+            srcp += pl.pitch;
+        }
+    }
+}
+
+
+static std::string hash_planes(framehash_t type, const std::vector<plane_t>& planes)
+{
+    if (type == FRAMEHASH_MD5) {
+        MD5 h;
+        hash_planes(h, planes);
+        return h.hex();
+    }
+    if (type == FRAMEHASH_CRC32) {
+        CRC32 h;
+        hash_planes(h, planes);
+        return std::format("{:08x}", h.digest());
+    }
+    XXH64 h;
+    hash_planes(h, planes);
+    return std::format("{:016x}", h.digest());
+}
+
+
+FrameHasher::FrameHasher(framehash_t t, const char* path, int num_threads) :
+    FramePrinter(path, num_threads), type(t), videoStream(0), audioStream(0),
+    audioBytes(1)
+{
+}
+
+
+FrameHasher::~FrameHasher()
+{
+    stopThreads();
+}
+
+
+// the index of a job is its stream.
+void FrameHasher::format(const job_t& job, std::string& text)
+{
+    int64_t size = 0;
+    for (const auto& pl : job.planes) {
+        size += static_cast<int64_t>(pl.rowsize) * pl.height;
+    }
+    const int64_t duration = job.index == videoStream ? 1 : size / audioBytes;
+    text += std::format("{}, {:10}, {:10}, {:8}, {:8}, {}\n", job.index,
+                        job.frame, job.frame, duration, size,
+                        hash_planes(type, job.planes));
+}
+
+
+void FrameHasher::
+writeHeader(const VideoInfo& vi, bool video, bool audio, int sarnum, int sarden)
+{
+    const char* names[] = { "", "MD5", "CRC32", "XXH64" };
+    fprintf(fp, "#format: frame checksums\n#version: 2\n#hash: %s\n"
+            "#software: avs2pipemod %s\n", names[type], A2PM_VERSION);
+    int stream = 0;
+    videoStream = video ? 0 : -1;
+    if (video) {
+        unsigned g = std::gcd(vi.fps_numerator, vi.fps_denominator);
+        fprintf(fp, "#tb %d: %u/%u\n#media_type %d: video\n"
+                "#codec_id %d: rawvideo\n#dimensions %d: %dx%d\n"
+                "#sar %d: %d/%d\n", stream, vi.fps_denominator / g,
+                vi.fps_numerator / g, stream, stream, stream, vi.width,
+                vi.height, stream, sarnum, sarden ? sarden : 1);
+        ++stream;
+    }
+    if (audio) {
+        const char* codec = vi.sample_type == SAMPLE_INT8 ? "pcm_u8" :
+                            vi.sample_type == SAMPLE_INT16 ? "pcm_s16le" :
+                            vi.sample_type == SAMPLE_INT24 ? "pcm_s24le" :
+                            vi.sample_type == SAMPLE_INT32 ? "pcm_s32le" :
+                            "pcm_f32le";
+        std::string layout = vi.nchannels == 1 ? "mono" :
+                             vi.nchannels == 2 ? "stereo" :
+                             std::format("{} channels", vi.nchannels);
+        fprintf(fp, "#tb %d: 1/%d\n#media_type %d: audio\n#codec_id %d: %s\n"
+                "#sample_rate %d: %d\n#channel_layout_name %d: %s\n", stream,
+                vi.audio_samples_per_second, stream, stream, codec, stream,
+                vi.audio_samples_per_second, stream, layout.c_str());
+        audioStream = stream;
+        audioBytes = vi.BytesPerAudioSample();
+    }
+    fprintf(fp, "#stream#, dts,        pts, duration,     size, hash\n");
+}
+
+
+void FrameHasher::
+addVideo(int64_t pts, const plane_t* planes, int num, const PVideoFrame& owner)
+{
+    add(pts, 0, planes, num, owner);
+}
+
+
+void FrameHasher::
+addAudio(int64_t pts, const void* data, size_t size)
+{
+    const plane_t block = { reinterpret_cast<const uint8_t*>(data),
+                            static_cast<int>(size), static_cast<int>(size), 1 };
+    add(pts, audioStream, &block, 1, PVideoFrame());
+}
+
+
+FrameHashOutput::
+FrameHashOutput(std::unique_ptr<Output> o, std::unique_ptr<FrameHasher> h,
+                int64_t first) :
+    out(std::move(o)), hasher(std::move(h)), frames(first) {}
+
+
+FrameHashOutput::~FrameHashOutput()
+{
+    hasher->finish();
+}
+
+
+bool FrameHashOutput::write(const void* data, size_t size)
+{
+    return out->write(data, size);
+}
+
+
+bool FrameHashOutput::
+writeFrame(const char* header, const plane_t* planes, int num,
+           const PVideoFrame& owner)
+{
+    hasher->addVideo(frames++, planes, num, owner);
+    return out->writeFrame(header, planes, num, owner);
+}
+
+
+bool FrameHashOutput::flush()
+{
+    return out->flush();
+}
+
+
+bool FrameHashOutput::sync()
+{
+    return out->sync();
+}
@@ -0,0 +1,77 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_FRAMEHASH_H
+#define A2PM_FRAMEHASH_H
+
+#include <memory>
+#include <string>
+#include "avs2pipemod.h"
+#include "frameprinter.h"
+#include "output.h"
+
+
+// hashes video frames and audio blocks on a pool of threads, and prints
+// them in order in the text format of ffmpeg's framehash/framemd5 muxers.
+class FrameHasher : public FramePrinter {
+    framehash_t type;
+    int videoStream;    // -1 if there is no video
+    int audioStream;
+    int audioBytes;     // per sample of all channels
+
+    void format(const job_t& job, std::string& text) override;
+
+public:
+    // path is nullptr for stdout. num_threads 0 is one per core, up to 8.
+    FrameHasher(framehash_t type, const char* path, int num_threads = 0);
+    ~FrameHasher();
+    // vi describes the planes that are hashed.
+    void writeHeader(const VideoInfo& vi, bool video, bool audio, int sarnum,
+                     int sarden);
+    // the planes are hashed as rows without padding, one after another.
+    // if owner is an empty frame, they are copied first.
+    void addVideo(int64_t pts, const plane_t* planes, int num,
+                  const PVideoFrame& owner);
+    // pts is the first sample of the block, which has size / vi.BytesPerAudioSample()
+    // samples.
+    void addAudio(int64_t pts, const void* data, size_t size);
+};
+
+
+// hashes every frame passed to another output.
+class FrameHashOutput : public Output {
+    std::unique_ptr<Output> out;
+    std::unique_ptr<FrameHasher> hasher;
+    int64_t frames;
+public:
+    // first is the number of the first frame that is written.
+    FrameHashOutput(std::unique_ptr<Output> out,
+                    std::unique_ptr<FrameHasher> hasher, int64_t first);
+    ~FrameHashOutput();
+    bool write(const void* data, size_t size) override;
+    bool writeFrame(const char* header, const plane_t* planes, int num,
+                    const PVideoFrame& owner) override;
+    bool flush() override;
+    bool sync() override;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include "framelist.h"
+#include "utils.h"
+
+
+std::vector<frame_range_t> read_frame_list(const char* path, int num_frames)
+{
+    FILE* fp = fopen(path, "rb");
+    validate(!fp, std::format("failed to open {}.\n", path));
+    std::string text;
+    char buff[4096];
+    for (size_t n; (n = fread(buff, 1, sizeof(buff), fp)) > 0;) {
+        text.append(buff, n);
+    }
+    fclose(fp);
+
+    std::vector<frame_range_t> ranges;
+    int line = 1;
+    const char* p = text.c_str();
+    while (*p) {
+        if (*p == '#') {
+            p += strcspn(p, "\n");
+            continue;
+        }
+        if (*p == '\n') {
+            ++line;
+        }
+        if (isspace(static_cast<unsigned char>(*p)) || *p == ',') {
+            ++p;
+            continue;
+        }
+
+        char* end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        bool ok = end != p && isdigit(static_cast<unsigned char>(*p));
+        if (ok && *end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            ok = end != p && isdigit(static_cast<unsigned char>(*p));
+        }
+        ok = ok && last >= first && (*end == '\0' || *end == ',' || *end == '#'
+                    || isspace(static_cast<unsigned char>(*end)));
+        validate(!ok, std::format("{}:{}: invalid frame or range.\n", path, line));
+        validate(last >= num_frames,
+                 std::format("{}:{}: frames {}-{} are out of the clip of {} "
+                             "frames.\n", path, line, first, last, num_frames));
+        p = end;
+
+        if (!ranges.empty() && ranges.back().last + 1 == first) {
+            ranges.back().last = last;
+        } else {
+            ranges.push_back({ static_cast<int>(first), static_cast<int>(last) });
+        }
+    }
+    validate(ranges.empty(), std::format("no frames found in {}.\n", path));
+    return ranges;
+}
+
+
+class FrameMap : public GenericVideoFilter {
+    std::vector<int> frames;        // source frame of each frame
+    std::vector<int64_t> srcAudio;  // first source sample of each range
+    std::vector<int64_t> outAudio;  // first sample of each range, and the end
+
+public:
+    FrameMap(PClip c, const std::vector<frame_range_t>& ranges) :
+        GenericVideoFilter(c)
+    {
+        const VideoInfo& src = child->GetVideoInfo();
+        outAudio.push_back(0);
+        for (const auto& r : ranges) {
+            for (int n = r.first; n <= r.last; ++n) {
+                frames.push_back(n);
+            }
+            int64_t start = src.AudioSamplesFromFrames(r.first);
+            int64_t end = std::min(src.AudioSamplesFromFrames(r.last + 1),
+                                   src.num_audio_samples);
+            srcAudio.push_back(start);
+            outAudio.push_back(outAudio.back() + std::max<int64_t>(end - start, 0));
+        }
+        vi.num_frames = static_cast<int>(frames.size());
+        if (vi.HasAudio()) {
+            vi.num_audio_samples = outAudio.back();
+        }
+    }
+
+    PVideoFrame __stdcall GetFrame(int n, ise_t* env) override
+    {
+        n = std::min(std::max(n, 0), vi.num_frames - 1);
+        return child->GetFrame(frames[n], env);
+    }
+
+    bool __stdcall GetParity(int n) override
+    {
+        n = std::min(std::max(n, 0), vi.num_frames - 1);
+        return child->GetParity(frames[n]);
+    }
+
+    void __stdcall
+    GetAudio(void* buf, int64_t start, int64_t count, ise_t* env) override
+    {
+        uint8_t* dst = reinterpret_cast<uint8_t*>(buf);
+        const int64_t bps = vi.BytesPerAudioSample();
+        while (count > 0) {
+            // samples out of the clip are silent.
+            if (start < 0 || start >= outAudio.back()) {
+                int64_t n = start < 0 ? std::min(count, -start) : count;
+                memset(dst, 0, static_cast<size_t>(n * bps));
+                dst += n * bps;
+                start += n;
+                count -= n;
+                continue;
+            }
+            size_t i = std::upper_bound(outAudio.begin(), outAudio.end(), start)
+                       - outAudio.begin() - 1;
+            int64_t n = std::min(count, outAudio[i + 1] - start);
+            child->GetAudio(dst, srcAudio[i] + start - outAudio[i], n, env);
+            dst += n * bps;
+            start += n;
+            count -= n;
+        }
+    }
+};
+
+
+PClip create_frame_map(PClip child, const std::vector<frame_range_t>& ranges)
+{
+    return new FrameMap(child, ranges);
+}
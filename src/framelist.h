@@ -0,0 +1,46 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_FRAMELIST_H
+#define A2PM_FRAMELIST_H
+
+#include <vector>
+#include "avs2pipemod.h"
+
+
+// consecutive frames of the source clip.
+struct frame_range_t {
+    int first;
+    int last;
+};
+
+// reads frame numbers separated by spaces, commas or new lines. an item is
+// a frame number or an inclusive range 'first-last'. '#' starts a comment.
+// consecutive frames are merged into one range, the order is kept.
+std::vector<frame_range_t> read_frame_list(const char* path, int num_frames);
+
+// a clip of the frames of 'ranges' in order, with the audio that belongs to
+// them. frames are requested from 'child' as they are, so that its cache and
+// the state of its filters are shared by all the ranges.
+PClip create_frame_map(PClip child, const std::vector<frame_range_t>& ranges);
+
+#endif
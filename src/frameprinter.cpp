@@ -0,0 +1,167 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include "frameprinter.h"
+#include "utils.h"
+
+
+FramePrinter::FramePrinter(const char* path, int num_threads) :
+    fp(stdout), stop(false)
+{
+    if (num_threads < 1) {
+        num_threads = std::clamp(
+            static_cast<int>(std::thread::hardware_concurrency()), 1, 8);
+    }
+    maxJobs = num_threads * 2;
+    if (path) {
+        fp = fopen(path, "w");
+        validate(!fp, std::format("failed to open {}.\n", path));
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        threads.emplace_back(&FramePrinter::run, this);
+    }
+}
+
+
+FramePrinter::~FramePrinter()
+{
+    stopThreads();
+    if (fp != stdout) {
+        fclose(fp);
+    }
+}
+
+
+void FramePrinter::stopThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    queued.notify_all();
+    for (auto& t : threads) {
+        t.join();
+    }
+    threads.clear();
+}
+
+
+void FramePrinter::run()
+{
+    while (true) {
+        std::shared_ptr<job_t> job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            queued.wait(lock, [this] { return stop || !todo.empty(); });
+            if (todo.empty()) {
+                return;
+            }
+            job = todo.front();
+            todo.pop_front();
+        }
+        format(*job, job->text);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            job->owner = nullptr;
+            job->copy = std::vector<uint8_t>();
+            job->done = true;
+        }
+        formatted.notify_all();
+    }
+}
+
+
+// prints the text that is ready, waiting until at most 'keep' jobs are left.
+void FramePrinter::print(std::unique_lock<std::mutex>& lock, size_t keep)
+{
+    while (!jobs.empty()) {
+        if (!jobs.front()->done) {
+            if (jobs.size() <= keep) {
+                return;
+            }
+            formatted.wait(lock, [this] { return jobs.front()->done; });
+        }
+        const std::string& text = jobs.front()->text;
+        fwrite(text.data(), 1, text.size(), fp);
+        spare.push_back(std::move(jobs.front()));
+        jobs.pop_front();
+    }
+}
+
+
+void FramePrinter::add(int64_t frame, int index, const plane_t* planes, int num,
+                       const PVideoFrame& owner)
+{
+    std::shared_ptr<job_t> job;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!spare.empty()) {
+            job = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+    if (job) {
+        job->text.clear();
+    } else {
+        job = std::make_shared<job_t>();
+    }
+    job->frame = frame;
+    job->index = index;
+    job->planes.assign(planes, planes + num);
+    job->owner = owner;
+    job->done = false;
+    if (!owner) {
+        size_t size = 0;
+        for (int p = 0; p < num; ++p) {
+            size += static_cast<size_t>(planes[p].rowsize) * planes[p].height;
+        }
+        job->copy.resize(size);
+        uint8_t* dstp = job->copy.data();
+        for (auto& pl : job->planes) {
+            const uint8_t* srcp = pl.ptr;
+            pl.ptr = dstp;
+            for (int y = 0; y < pl.height; ++y) {
+                memcpy(dstp, srcp, pl.rowsize);
+                dstp += pl.rowsize;
+                srcp += pl.pitch;
+            }
+            pl.pitch = pl.rowsize;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(mtx);
+    jobs.push_back(job);
+    todo.push_back(job);
+    queued.notify_one();
+    print(lock, maxJobs);
+}
+
+
+void FramePrinter::finish()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    print(lock, 0);
+    fflush(fp);
+}
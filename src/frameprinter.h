@@ -0,0 +1,86 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_FRAMEPRINTER_H
+#define A2PM_FRAMEPRINTER_H
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "avs2pipemod.h"
+#include "output.h"
+
+
+// formats parts of frames as text on a pool of threads, and prints the text
+// in the order the parts were added.
+class FramePrinter {
+protected:
+    struct job_t {
+        int64_t frame;
+        int index;                  // which part of the frame
+        std::vector<plane_t> planes;
+        PVideoFrame owner;          // keeps the memory of planes alive
+        std::vector<uint8_t> copy;  // or the data itself
+        std::string text;
+        bool done;
+    };
+    FILE* fp;
+
+    // called on the threads of the pool. text is empty, but keeps the
+    // capacity it had for an earlier job.
+    virtual void format(const job_t& job, std::string& text) = 0;
+    // if owner is an empty frame, the planes are only valid during the
+    // call and are copied.
+    void add(int64_t frame, int index, const plane_t* planes, int num,
+             const PVideoFrame& owner);
+    // finishes the jobs that are left. classes that override format() call
+    // it in their destructor.
+    void stopThreads();
+
+private:
+    size_t maxJobs;
+    bool stop;
+    std::deque<std::shared_ptr<job_t>> jobs;    // in the order of the text
+    std::deque<std::shared_ptr<job_t>> todo;
+    std::vector<std::shared_ptr<job_t>> spare;  // printed jobs to reuse
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable queued;
+    std::condition_variable formatted;
+
+    void run();
+    void print(std::unique_lock<std::mutex>& lock, size_t keep);
+
+public:
+    // path is nullptr for stdout. num_threads 0 is one per core, up to 8.
+    FramePrinter(const char* path, int num_threads = 0);
+    virtual ~FramePrinter();
+    // prints all the remaining text.
+    void finish();
+};
+
+#endif
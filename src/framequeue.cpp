@@ -0,0 +1,62 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include "framequeue.h"
+
+
+FrameQueue::FrameQueue(size_t depth) :
+    ring(depth), capacity(depth), head(0), tail(0) {}
+
+
+void FrameQueue::push(const PVideoFrame& frame)
+{
+    const size_t t = tail.load(std::memory_order_relaxed);
+    size_t h = head.load(std::memory_order_acquire);
+    while (t - h >= capacity) {
+        head.wait(h, std::memory_order_acquire);
+        h = head.load(std::memory_order_acquire);
+    }
+    ring[t % capacity] = frame;
+    tail.store(t + 1, std::memory_order_release);
+    tail.notify_one();
+}
+
+
+PVideoFrame FrameQueue::pop()
+{
+    const size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    while (t == h) {
+        tail.wait(t, std::memory_order_acquire);
+        t = tail.load(std::memory_order_acquire);
+    }
+    PVideoFrame frame = ring[h % capacity];
+    ring[h % capacity] = nullptr;
+    head.store(h + 1, std::memory_order_release);
+    head.notify_one();
+    return frame;
+}
+
+
+void FrameQueue::close()
+{
+    push(PVideoFrame());
+}
@@ -0,0 +1,48 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#ifndef A2PM_FRAMEQUEUE_H
+#define A2PM_FRAMEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include "avs2pipemod.h"
+
+
+// bounded single-producer/single-consumer ring of frames.
+// push() blocks while the ring is full and pop() blocks while it is empty,
+// both without locks (C++20 atomic wait/notify).
+// close() queues an empty frame that tells the consumer to finish.
+class FrameQueue {
+    std::vector<PVideoFrame> ring;
+    const size_t capacity;
+    alignas(64) std::atomic<size_t> head;   // written by the consumer only
+    alignas(64) std::atomic<size_t> tail;   // written by the producer only
+
+public:
+    explicit FrameQueue(size_t depth);
+    void push(const PVideoFrame& frame);
+    PVideoFrame pop();
+    void close();
+};
+
+#endif
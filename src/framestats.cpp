@@ -0,0 +1,159 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+#include "framestats.h"
+#include "metrics.h"
+#include "utils.h"
+
+
+// float chroma is centered at 0.
+template <typename T>
+static void
+make_histogram(const plane_t& pl, int bits, bool chroma, std::vector<uint64_t>& hist)
+{
+    const int width = pl.rowsize / static_cast<int>(sizeof(T));
+    const int bins = static_cast<int>(hist.size());
+    const float offset = chroma ? 0.5f : 0.0f;
+    const uint8_t* srcp = pl.ptr;
+    for (int y = 0; y < pl.height; ++y) {
+        const T* s = reinterpret_cast<const T*>(srcp);
+        for (int x = 0; x < width; ++x) {
+            int i;
+            if constexpr (std::is_floating_point_v<T>) {
+                i = static_cast<int>(std::clamp((s[x] + offset) * bins, 0.0f,
+                                                bins - 1.0f));
+            } else {
+                i = std::min(static_cast<int>((static_cast<int64_t>(s[x]) * bins) >> bits),
+                             bins - 1);
+            }
+            ++hist[i];
+        }
+        srcp += pl.pitch;
+    }
+}
+
+
+template <typename T>
+static row_stats_t get_plane_stats(const plane_t& pl)
+{
+    auto stats_row = has_avx2() ? stats_row_avx2<T> : stats_row_sse2<T>;
+    const int width = pl.rowsize / static_cast<int>(sizeof(T));
+    row_stats_t s = { std::numeric_limits<double>::infinity(),
+                      -std::numeric_limits<double>::infinity(), 0.0, 0.0 };
+    const uint8_t* srcp = pl.ptr;
+    for (int y = 0; y < pl.height; ++y) {
+        stats_row(reinterpret_cast<const T*>(srcp), width, s);
+        srcp += pl.pitch;
+    }
+    return s;
+}
+
+
+FrameStats::
+FrameStats(const char* path, bool j, const std::vector<std::string>& n,
+           int b, int num_bins, int num_threads) :
+    FramePrinter(path, num_threads), json(j), bits(b), bins(num_bins), names(n)
+{
+    if (bits < 32) {
+        bins = std::min(bins, 1 << bits);
+    }
+    if (!json) {
+        fprintf(fp, "frame,plane,min,max,mean,stddev%s\n",
+                bins > 0 ? ",histogram" : "");
+    }
+}
+
+
+FrameStats::~FrameStats()
+{
+    stopThreads();
+}
+
+
+// the lines of all planes of a frame. the standard deviation is the one of
+// the population.
+void FrameStats::format(const job_t& job, std::string& text)
+{
+    std::vector<uint64_t> hist(bins);
+    for (size_t p = 0; p < job.planes.size(); ++p) {
+        const plane_t& pl = job.planes[p];
+        const bool chroma = names[p] == "u" || names[p] == "v";
+        row_stats_t s;
+        std::fill(hist.begin(), hist.end(), 0);
+        if (bits == 8) {
+            s = get_plane_stats<uint8_t>(pl);
+            if (bins > 0) {
+                make_histogram<uint8_t>(pl, bits, chroma, hist);
+            }
+        } else if (bits == 32) {
+            s = get_plane_stats<float>(pl);
+            if (bins > 0) {
+                make_histogram<float>(pl, bits, chroma, hist);
+            }
+        } else {
+            s = get_plane_stats<uint16_t>(pl);
+            if (bins > 0) {
+                make_histogram<uint16_t>(pl, bits, chroma, hist);
+            }
+        }
+
+        const int bytes = bits == 8 ? 1 : bits == 32 ? 4 : 2;
+        const double count = static_cast<double>(pl.rowsize / bytes) * pl.height;
+        const double mean = s.sum / count;
+        const double stddev = std::sqrt(std::max(s.sumsq / count - mean * mean, 0.0));
+        std::string min = bits == 32 ? std::format("{:.6f}", s.min)
+                                     : std::format("{}", static_cast<int>(s.min));
+        std::string max = bits == 32 ? std::format("{:.6f}", s.max)
+                                     : std::format("{}", static_cast<int>(s.max));
+
+        if (json) {
+            text += std::format("{{\"frame\": {}, \"plane\": \"{}\", \"min\": {}, "
+                                "\"max\": {}, \"mean\": {:.6f}, \"stddev\": {:.6f}",
+                                job.frame, names[p], min, max, mean, stddev);
+            if (bins > 0) {
+                text += ", \"histogram\": [";
+                for (int i = 0; i < bins; ++i) {
+                    text += std::format("{}{}", i > 0 ? ", " : "", hist[i]);
+                }
+                text += "]";
+            }
+            text += "}\n";
+        } else {
+            text += std::format("{},{},{},{},{:.6f},{:.6f}", job.frame, names[p],
+                                min, max, mean, stddev);
+            for (int i = 0; i < bins; ++i) {
+                text += std::format("{}{}", i > 0 ? " " : ",", hist[i]);
+            }
+            text += "\n";
+        }
+    }
+}
+
+
+void FrameStats::add(int n, const plane_t* planes, const PVideoFrame& owner)
+{
+    FramePrinter::add(n, 0, planes, static_cast<int>(names.size()), owner);
+}
@@ -0,0 +1,54 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_FRAMESTATS_H
+#define A2PM_FRAMESTATS_H
+
+#include <string>
+#include <vector>
+#include "frameprinter.h"
+
+
+// computes the minimum, maximum, mean, standard deviation and histogram of
+// every plane of the frames on a pool of threads, and prints them in order
+// as CSV or NDJSON, one line per plane.
+class FrameStats : public FramePrinter {
+    bool json;
+    int bits;
+    int bins;
+    std::vector<std::string> names;
+
+    void format(const job_t& job, std::string& text) override;
+
+public:
+    // path is nullptr for stdout. bits is the bit depth of the samples, 32
+    // for float. no histogram is made if bins is 0. num_threads 0 is one per
+    // core, up to 8.
+    FrameStats(const char* path, bool json,
+               const std::vector<std::string>& names, int bits, int bins,
+               int num_threads = 0);
+    ~FrameStats();
+    // names.size() planes of the frame n.
+    void add(int n, const plane_t* planes, const PVideoFrame& owner);
+};
+
+#endif
@@ -0,0 +1,352 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_HASH_H
+#define A2PM_HASH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+
+// streaming XXH64, for checking that renders are identical.
+class XXH64 {
+    static constexpr uint64_t P1 = 0x9E3779B185EBCA87ULL;
+    static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4FULL;
+    static constexpr uint64_t P3 = 0x165667B19E3779F9ULL;
+    static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ULL;
+    static constexpr uint64_t P5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t seed;
+    uint64_t acc[4];
+    uint64_t total;
+    uint8_t mem[32];
+    size_t memsize;
+
+    static uint64_t rotl(uint64_t x, int r) { return x << r | x >> (64 - r); }
+
+    static uint64_t read64(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        return v;
+    }
+
+    static uint32_t read32(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static uint64_t round(uint64_t acc, uint64_t input)
+    {
+        return rotl(acc + input * P2, 31) * P1;
+    }
+
+    static uint64_t merge(uint64_t acc, uint64_t val)
+    {
+        return (acc ^ round(0, val)) * P1 + P4;
+    }
+
+    void stripe(const uint8_t* p)
+    {
+        for (int i = 0; i < 4; ++i) {
+            acc[i] = round(acc[i], read64(p + 8 * i));
+        }
+    }
+
+public:
+    explicit XXH64(uint64_t s = 0) : seed(s), total(0), memsize(0)
+    {
+        acc[0] = seed + P1 + P2;
+        acc[1] = seed + P2;
+        acc[2] = seed;
+        acc[3] = seed - P1;
+    }
+
+    void update(const void* data, size_t size)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t* end = p + size;
+        total += size;
+
+        if (memsize + size < 32) {
+            memcpy(mem + memsize, p, size);
+            memsize += size;
+            return;
+        }
+        if (memsize > 0) {
+            size_t fill = 32 - memsize;
+            memcpy(mem + memsize, p, fill);
+            stripe(mem);
+            p += fill;
+            memsize = 0;
+        }
+        for (; end - p >= 32; p += 32) {
+            stripe(p);
+        }
+        memsize = end - p;
+        memcpy(mem, p, memsize);
+    }
+
+    uint64_t digest() const
+    {
+        uint64_t h;
+        if (total >= 32) {
+            h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12)
+                + rotl(acc[3], 18);
+            for (int i = 0; i < 4; ++i) {
+                h = merge(h, acc[i]);
+            }
+        } else {
+            h = seed + P5;
+        }
+        h += total;
+
+        const uint8_t* p = mem;
+        const uint8_t* end = mem + memsize;
+        for (; end - p >= 8; p += 8) {
+            h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+        }
+        if (end - p >= 4) {
+            h = rotl(h ^ read32(p) * P1, 23) * P2 + P3;
+            p += 4;
+        }
+        for (; p < end; ++p) {
+            h = rotl(h ^ *p * P5, 11) * P1;
+        }
+
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    // the state as hex digits, so that another process can continue it.
+    std::string save() const
+    {
+        uint64_t v[] = { seed, acc[0], acc[1], acc[2], acc[3], total };
+        std::string ret;
+        char buff[20];
+        for (uint64_t x : v) {
+            snprintf(buff, sizeof(buff), "%016llx",
+                     static_cast<unsigned long long>(x));
+            ret += buff;
+        }
+        for (size_t i = 0; i < memsize; ++i) {
+            snprintf(buff, sizeof(buff), "%02x", mem[i]);
+            ret += buff;
+        }
+        return ret;
+    }
+
+    bool load(const std::string& s)
+    {
+        if (s.size() < 96 || s.size() >= 96 + 64 || s.size() % 2 != 0) {
+            return false;
+        }
+        uint64_t v[6];
+        for (int i = 0; i < 6; ++i) {
+            v[i] = strtoull(s.substr(i * 16, 16).c_str(), nullptr, 16);
+        }
+        seed = v[0];
+        memcpy(acc, v + 1, sizeof(acc));
+        total = v[5];
+        memsize = (s.size() - 96) / 2;
+        for (size_t i = 0; i < memsize; ++i) {
+            mem[i] = static_cast<uint8_t>(
+                strtoul(s.substr(96 + i * 2, 2).c_str(), nullptr, 16));
+        }
+        return total % 32 == memsize;
+    }
+};
+
+
+
+// streaming MD5 (RFC 1321).
+class MD5 {
+    uint32_t h[4];
+    uint64_t total;
+    uint8_t mem[64];
+    size_t memsize;
+
+    static uint32_t rotl(uint32_t x, int r) { return x << r | x >> (32 - r); }
+
+    void block(const uint8_t* p)
+    {
+        static constexpr uint32_t K[64] = {
+            0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf,
+            0x4787c62a, 0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af,
+            0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e,
+            0x49b40821, 0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+            0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8, 0x21e1cde6,
+            0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+            0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122,
+            0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+            0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039,
+            0xe6db99e5, 0x1fa27cf8, 0xc4ac5665, 0xf4292244, 0x432aff97,
+            0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d,
+            0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+            0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+        };
+        static constexpr int R[16] = {
+            7, 12, 17, 22, 5, 9, 14, 20, 4, 11, 16, 23, 6, 10, 15, 21,
+        };
+        uint32_t m[16];
+        memcpy(m, p, 64);
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t f;
+            int g;
+            if (i < 16) {
+                f = (b & c) | (~b & d);
+                g = i;
+            } else if (i < 32) {
+                f = (d & b) | (~d & c);
+                g = (5 * i + 1) & 15;
+            } else if (i < 48) {
+                f = b ^ c ^ d;
+                g = (3 * i + 5) & 15;
+            } else {
+                f = c ^ (b | ~d);
+                g = (7 * i) & 15;
+            }
+            f += a + K[i] + m[g];
+            a = d;
+            d = c;
+            c = b;
+            b += rotl(f, R[(i >> 4) * 4 + (i & 3)]);
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+    }
+
+public:
+    MD5() : h{ 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 }, total(0),
+            memsize(0) {}
+
+    void update(const void* data, size_t size)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        total += size;
+        if (memsize > 0) {
+            size_t fill = std::min(size, 64 - memsize);
+            memcpy(mem + memsize, p, fill);
+            memsize += fill;
+            p += fill;
+            size -= fill;
+            if (memsize < 64) {
+                return;
+            }
+            block(mem);
+            memsize = 0;
+        }
+        for (; size >= 64; p += 64, size -= 64) {
+            block(p);
+        }
+        memcpy(mem, p, size);
+        memsize = size;
+    }
+
+    std::string hex() const
+    {
+        MD5 c = *this;
+        const uint64_t bits = total * 8;
+        const uint8_t pad = 0x80;
+        c.update(&pad, 1);
+        const uint8_t zero[64] = {};
+        c.update(zero, (120 - c.memsize) % 64);
+        c.update(&bits, 8);
+        std::string ret;
+        char buff[4];
+        for (int i = 0; i < 16; ++i) {
+            snprintf(buff, sizeof(buff), "%02x", (c.h[i / 4] >> (i % 4 * 8)) & 0xFF);
+            ret += buff;
+        }
+        return ret;
+    }
+};
+
+
+// CRC-32 of zlib/ISO-HDLC, 8 bytes at a time.
+class CRC32 {
+    struct table_t {
+        uint32_t t[8][256];
+        table_t()
+        {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {
+                    c = c & 1 ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+                }
+                t[0][i] = c;
+            }
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (int k = 1; k < 8; ++k) {
+                    t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+    uint32_t crc;
+
+    static const table_t& table()
+    {
+        static const table_t tab;
+        return tab;
+    }
+
+public:
+    CRC32() : crc(0xFFFFFFFF) {}
+
+    void update(const void* data, size_t size)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        const auto& t = table().t;
+        uint32_t c = crc;
+        for (; size >= 8; p += 8, size -= 8) {
+            uint32_t lo, hi;
+            memcpy(&lo, p, 4);
+            memcpy(&hi, p + 4, 4);
+            lo ^= c;
+            c = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF]
+                ^ t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF]
+                ^ t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+        }
+        for (; size > 0; ++p, --size) {
+            c = t[0][(c ^ *p) & 0xFF] ^ (c >> 8);
+        }
+        crc = c;
+    }
+
+    uint32_t digest() const { return crc ^ 0xFFFFFFFF; }
+};
+
+#endif
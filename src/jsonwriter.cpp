@@ -0,0 +1,131 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <charconv>
+#include <cmath>
+#include "jsonwriter.h"
+
+
+void JsonWriter::separate()
+{
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (depth > 0) {
+        const uint64_t bit = 1ULL << (depth - 1);
+        if (empty & bit) {
+            empty &= ~bit;
+        } else {
+            out += ", ";
+        }
+    }
+}
+
+
+void JsonWriter::begin(char c)
+{
+    separate();
+    out += c;
+    if (depth < 64) {
+        empty |= 1ULL << depth;
+    }
+    ++depth;
+}
+
+
+void JsonWriter::end(char c)
+{
+    --depth;
+    out += c;
+}
+
+
+void JsonWriter::key(std::string_view k)
+{
+    value(k);
+    out += ": ";
+    afterKey = true;
+}
+
+
+void JsonWriter::value(int64_t v)
+{
+    separate();
+    char buf[24];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v);
+    out.append(buf, r.ptr);
+}
+
+
+void JsonWriter::value(double v, int precision)
+{
+    if (!std::isfinite(v)) {
+        null();
+        return;
+    }
+    separate();
+    // enough for DBL_MAX in fixed notation.
+    char buf[352];
+    auto r = std::to_chars(buf, buf + sizeof(buf), v, std::chars_format::fixed,
+                           precision);
+    out.append(buf, r.ptr);
+}
+
+
+void JsonWriter::value(std::string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+    separate();
+    out += '"';
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(s.data() + start, i - start);
+        start = i + 1;
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\b': out += "\\b"; break;
+        case '\f': out += "\\f"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            out += "\\u00";
+            out += hex[c >> 4];
+            out += hex[c & 15];
+        }
+    }
+    out.append(s.data() + start, s.size() - start);
+    out += '"';
+}
+
+
+void JsonWriter::null()
+{
+    separate();
+    out += "null";
+}
@@ -0,0 +1,61 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_JSONWRITER_H
+#define A2PM_JSONWRITER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+// appends JSON to a string. nothing is allocated once the string has the
+// capacity of the longest document, so the same string can be reused for
+// every frame. commas are inserted between the elements of arrays and
+// objects, and the separators are ", " and ": ".
+class JsonWriter {
+    std::string& out;
+    uint64_t empty;     // a bit per level of nesting, set until it has an element
+    int depth;
+    bool afterKey;
+
+    void separate();
+    void begin(char c);
+    void end(char c);
+
+public:
+    JsonWriter(std::string& out) : out(out), empty(0), depth(0), afterKey(false) {}
+    void beginObject() { begin('{'); }
+    void endObject() { end('}'); }
+    void beginArray() { begin('['); }
+    void endArray() { end(']'); }
+    void key(std::string_view k);
+    void value(int64_t v);
+    // fixed notation with precision digits after the point. infinities and
+    // NaN are null.
+    void value(double v, int precision);
+    // escaped, bytes above 0x7f are passed as they are.
+    void value(std::string_view s);
+    void null();
+};
+
+#endif
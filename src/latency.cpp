@@ -0,0 +1,174 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include <limits>
+#include "jsonwriter.h"
+#include "latency.h"
+
+
+static constexpr struct {
+    const char* name;
+    double q;
+} PERCENTILES[] = {
+    { "p50", 0.5 }, { "p90", 0.9 }, { "p99", 0.99 }, { "p99.9", 0.999 },
+};
+
+
+LatencyHistogram::LatencyHistogram(size_t max_slowest) :
+    counts(index(std::numeric_limits<uint64_t>::max()) + 1, 0),
+    maxSlowest(max_slowest), count(0), min(std::numeric_limits<uint64_t>::max()),
+    max(0), sum(0.0)
+{
+}
+
+
+// larger values keep their highest SUB_BITS + 1 bits. the shift is in the
+// bits above them.
+size_t LatencyHistogram::index(uint64_t ns)
+{
+    const int shift = std::max(static_cast<int>(std::bit_width(ns)) - (SUB_BITS + 1), 0);
+    return (static_cast<size_t>(shift) << SUB_BITS) + static_cast<size_t>(ns >> shift);
+}
+
+
+uint64_t LatencyHistogram::upper(size_t index)
+{
+    if (index < (2u << SUB_BITS)) {
+        return index;
+    }
+    const int shift = static_cast<int>(index >> SUB_BITS) - 1;
+    const uint64_t m = (index & ((1u << SUB_BITS) - 1)) + (1u << SUB_BITS);
+    return ((m + 1) << shift) - 1;
+}
+
+
+void LatencyHistogram::add(int frame, uint64_t ns)
+{
+    ++counts[index(ns)];
+    ++count;
+    min = std::min(min, ns);
+    max = std::max(max, ns);
+    sum += static_cast<double>(ns);
+
+    auto later = std::greater<std::pair<uint64_t, int>>();
+    if (slowest.size() < maxSlowest) {
+        slowest.emplace_back(ns, frame);
+        std::push_heap(slowest.begin(), slowest.end(), later);
+    } else if (maxSlowest > 0 && ns > slowest.front().first) {
+        std::pop_heap(slowest.begin(), slowest.end(), later);
+        slowest.back() = { ns, frame };
+        std::push_heap(slowest.begin(), slowest.end(), later);
+    }
+}
+
+
+uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(
+        static_cast<uint64_t>(q * static_cast<double>(count) + 0.5), 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(upper(i), max);
+        }
+    }
+    return max;
+}
+
+
+std::vector<std::pair<uint64_t, int>> LatencyHistogram::slowestFrames() const
+{
+    auto v = slowest;
+    std::sort(v.begin(), v.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+    return v;
+}
+
+
+std::string LatencyHistogram::summary() const
+{
+    if (count == 0) {
+        return std::string();
+    }
+    std::string s = std::format("frame latency[ms]: min {:.3f}  mean {:.3f}",
+                                min / 1e6, sum / count / 1e6);
+    for (const auto& p : PERCENTILES) {
+        s += std::format("  {} {:.3f}", p.name, percentile(p.q) / 1e6);
+    }
+    s += std::format("  max {:.3f}\nslowest frames:", max / 1e6);
+    for (const auto& [ns, frame] : slowestFrames()) {
+        s += std::format(" {} ({:.3f})", frame, ns / 1e6);
+    }
+    return s + "\n";
+}
+
+
+void LatencyHistogram::write(JsonWriter& w) const
+{
+    w.beginObject();
+    w.key("count");
+    w.value(static_cast<int64_t>(count));
+    w.key("min_ms");
+    w.value(count > 0 ? min / 1e6 : 0.0, 6);
+    w.key("mean_ms");
+    w.value(count > 0 ? sum / count / 1e6 : 0.0, 6);
+    for (const auto& p : PERCENTILES) {
+        w.key(std::format("{}_ms", p.name));
+        w.value(percentile(p.q) / 1e6, 6);
+    }
+    w.key("max_ms");
+    w.value(max / 1e6, 6);
+
+    w.key("slowest");
+    w.beginArray();
+    for (const auto& [ns, frame] : slowestFrames()) {
+        w.beginObject();
+        w.key("frame");
+        w.value(static_cast<int64_t>(frame));
+        w.key("ms");
+        w.value(ns / 1e6, 6);
+        w.endObject();
+    }
+    w.endArray();
+
+    w.key("histogram");
+    w.beginArray();
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        w.beginArray();
+        w.value(upper(i) / 1e6, 6);
+        w.value(static_cast<int64_t>(counts[i]));
+        w.endArray();
+    }
+    w.endArray();
+    w.endObject();
+}
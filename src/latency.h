@@ -0,0 +1,64 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_LATENCY_H
+#define A2PM_LATENCY_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+class JsonWriter;
+
+
+// a histogram of latencies in nanoseconds with buckets on a log-linear scale
+// like HdrHistogram: values below 256 are exact, larger ones are recorded with
+// 128 buckets per power of two, so percentiles are within 1% of the value.
+// the slowest frames are kept as well.
+class LatencyHistogram {
+    static constexpr int SUB_BITS = 7;
+    std::vector<uint64_t> counts;
+    std::vector<std::pair<uint64_t, int>> slowest;  // min-heap of (ns, frame)
+    size_t maxSlowest;
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+
+    static size_t index(uint64_t ns);
+    static uint64_t upper(size_t index);
+
+public:
+    LatencyHistogram(size_t max_slowest = 10);
+    void add(int frame, uint64_t ns);
+    // the highest value of the bucket of the q quantile (0 <= q <= 1).
+    uint64_t percentile(double q) const;
+    // the slowest frames, the slowest first.
+    std::vector<std::pair<uint64_t, int>> slowestFrames() const;
+    // two lines of percentiles and slowest frames in milliseconds.
+    std::string summary() const;
+    // an object of the same, and the non-empty buckets as [upper_ms, count].
+    void write(JsonWriter& w) const;
+};
+
+#endif
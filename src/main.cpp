@@ -21,6 +21,7 @@
 #include <memory>
 #include <format>
 #include "avs2pipemod.h"
+#include "manifest.h"
 #include "utils.h"
 #include "getopt.h"
 
@@ -58,8 +59,20 @@ static void usage()
 "   -y4mb[=sar  default 0:0]\n"
 "        output yuv4mpeg2 format video to stdout as bff interlaced.\n"
 "\n"
-"   -rawvideo[=vflip default unset]\n"
+"   -y4mbits=bits[,dither  default none]\n"
+"        in yuv4mpeg2 output modes, convert the clip to this bit depth\n"
+"        (8, 10, 12, 14 or 16) while writing.\n"
+"        dither is one of none(round), ordered or errdiff(Floyd-Steinberg).\n"
+"\n"
+"   -rawvideo[=vflip|nv12|p010|p016|v210|rgb24|bgr24|rgb48|rgba\n"
+"             default unset]\n"
 "        output rawvideo(without any header) to stdout.\n"
+"        vflip flips the image vertically.\n"
+"        nv12, p010 and p016 output YUV420 with interleaved U/V samples.\n"
+"        p010 is 10bit and p016 is 16bit or less, both MSB aligned.\n"
+"        v210 packs 10bit YUV422 into 32bit words, 128 bytes aligned lines.\n"
+"        rgb24, bgr24, rgb48 and rgba interleave planar RGB clips.\n"
+"        rgba is 8bit or 16bit per sample, following the clip.\n"
 "\n"
 #if 0
 "   -x264bdp[=4:3  default unset(16:9)]\n"
@@ -83,16 +96,162 @@ static void usage()
 "\n"
 "   -filters - output external plugin filters/functions list to stdout.\n"
 "\n"
-"   -benchmark - do benchmark avs script, and output results to stdout.\n"
+"   -benchmark[=<file.json>]\n"
+"        do benchmark avs script, and output results to stdout. every frame\n"
+"        is timed, and the percentiles of the frame latency and the slowest\n"
+"        frames are printed too. with file.json, they are also written to\n"
+"        it with the histogram of the latencies.\n"
 "\n"
 "   -dumptxt - dump pixel values as tab separated text to stdout.\n"
+"        the planes are formatted on several threads.\n"
+"\n"
+"   -dumpnpy=<file.npy|directory>\n"
+"        write the planes as NumPy arrays that np.memmap/np.load can map\n"
+"        as they are. file.npy gets one array of frames x planes x height x\n"
+"        width, which needs planes of the same size. a directory gets one\n"
+"        array of frames x height x width per plane, such as y.npy. samples\n"
+"        are u1, u2 or f4. the files are written without the system file\n"
+"        cache. with -fields, each field is a frame of the arrays.\n"
+"\n"
+"   -roi=x,y,width,height\n"
+"        in -dumptxt and -dumpnpy, dump only this rectangle of the frames,\n"
+"        in pixels.\n"
+"\n"
+"   -planes=<letters>\n"
+"        in -dumptxt and -dumpnpy, dump only these planes, in this order.\n"
+"        letters are y, u, v and a for YUV, or g, b, r and a for RGB.\n"
+"        e.g. -planes=y\n"
+"\n"
+"   -framestep=step\n"
+"        in -dumptxt and -dumpnpy, dump only every step-th frame, starting\n"
+"        from the first.\n"
+"\n"
+"   -dumpprops[=json|ndjson|columnar  default json]\n"
+"        dump frame properties to stdout, or to the file of -o, as a JSON\n"
+"        array of one object per frame, or as NDJSON, one object per line.\n"
+"        they are formatted on several threads, and -prefetch/-workers\n"
+"        render the frames ahead.\n"
+"        columnar writes a binary file that can be memory mapped, with a\n"
+"        column of int64, float64, utf8, binary or lists of int64/float64\n"
+"        per key in the layout of Apache Arrow arrays, and a JSON index at\n"
+"        the end. the index size is the uint64 before the last 8 bytes.\n"
+"\n"
+"   -props=key1,key2,...\n"
+"        in -dumpprops and -propstats, only these properties, in this order.\n"
+"\n"
+"   -propstats[=text|json[,max_distinct]  default text,16]\n"
+"        walk the frames like -dumpprops, and print one summary of every\n"
+"        property to stdout, or to the file of -o: the frames that have it,\n"
+"        min, max and mean of int and float values, and the counts of the\n"
+"        distinct values of int and string properties, most frequent first.\n"
+"        values beyond max_distinct distinct ones are counted as others.\n"
+"\n"
+"   -framehash=md5|crc32|xxh64[,file]\n"
+"        print the hash of every frame as -rawvideo writes it, and of the\n"
+"        audio of every frame, in the format of ffmpeg's framehash muxer,\n"
+"        to stdout or the file. hashing is spread over several threads.\n"
+"        with -y4m*/-rawvideo, hash the frames that are written instead.\n"
+"        the file is needed then unless -o is used.\n"
+"\n"
+"   -compare=<reference.avs>[,csv|json  default csv]\n"
+"        import the reference script into a second script environment and\n"
+"        print the PSNR and SSIM of each plane of every frame against it as\n"
+"        CSV or JSON to stdout, or to the file of -o. the average and the\n"
+"        worst frame are logged at the end, and added to JSON output.\n"
+"        both clips are rendered ahead in parallel. -trim, -frames,\n"
+"        -prefetch and -workers apply to both.\n"
 "\n"
-"   -dumpprops - dump frame properties as JSON string to stdout.\n"
+"   -stats[=csv|ndjson[,bins]  default csv]\n"
+"        print min, max, mean and standard deviation of each plane of every\n"
+"        frame as CSV or NDJSON to stdout, or to the file of -o, computed on\n"
+"        several threads. with bins, add a histogram of this many bins over\n"
+"        the range of the samples: 0 to the peak value for integer formats,\n"
+"        [0, 1] for float, or [-0.5, 0.5] for float chroma.\n"
 "\n"
 "   -trim[=first_frame,last_frame  default 0,0]\n"
 "        add Trim(first_frame,last_frame) to input script.\n"
 "        in info, this option is ignored.\n"
 "\n"
+"   -frames=<file>\n"
+"        take only the frames listed in the file, in the order of the file,\n"
+"        together with their audio. items are frame numbers or inclusive\n"
+"        ranges such as 100-250, separated by spaces, commas or new lines.\n"
+"        '#' starts a comment. frame numbers are those after -trim.\n"
+"        in info, this option is ignored.\n"
+"\n"
+"   -crop=left,top,right,bottom\n"
+"        in video output modes, -dumptxt and -dumpnpy, write only the inside\n"
+"        of these margins.\n"
+"        the frames are not copied for it.\n"
+"\n"
+"   -fields=tff|bff\n"
+"        in video output modes, write each frame as two fields of half height\n"
+"        at double frame rate, top or bottom field first.\n"
+"        the frames are not copied for it.\n"
+"\n"
+"   -fieldbased=weave|assume  default weave\n"
+"        in yuv4mpeg2 output modes, add Weave() or AssumeFrameBased() to\n"
+"        FieldBased clips.\n"
+"\n"
+"   -prefetch[=number of frames  default 0]\n"
+"        in video output modes, request up to this number of frames ahead\n"
+"        with the same number of threads. frames are still written in order.\n"
+"        the script must be safe to be called from multiple threads.\n"
+"\n"
+"   -queue[=number of frames  default 0]\n"
+"        in video output modes, write frames to stdout on a dedicated thread\n"
+"        through a queue of this depth, so that rendering and writing overlap.\n"
+"\n"
+"   -workers=number of environments[,chunk  default 24]\n"
+"        in video output modes, import the script into this number of\n"
+"        script environments and render chunks of consecutive frames with\n"
+"        them in parallel. for scripts that are not MT-safe.\n"
+"        the main environment is kept for audio and frame properties, so\n"
+"        the script is imported once more than this number.\n"
+"        up to (number of environments * chunk) frames are held in memory.\n"
+"        -prefetch is ignored when this is set.\n"
+"\n"
+"   -chunks=number of chunks\n"
+"   -chunk-size=number of frames\n"
+"   -chunk-index=index  default 0\n"
+"        in video output modes, cut the clip into this number of chunks, or\n"
+"        chunks of this number of frames, and write only the chunk of index\n"
+"        (from 0) to the file of -o. the boundaries depend only on the number\n"
+"        of frames, so that chunks can be rendered on different machines.\n"
+"        a manifest entry with the frame range, size, xxh64 and elapsed time\n"
+"        is written to <output>.json.\n"
+"\n"
+"   -concat <manifest>\n"
+"        check the entries of the manifest (e.g. the .json files of all the\n"
+"        chunks put together with cat) and write the chunk files, found in\n"
+"        the directory of the manifest, in order to -o or stdout.\n"
+"        on Linux, files are copied with copy_file_range().\n"
+"        e.g. avs2pipemod -concat manifest.json -o output.y4m\n"
+"\n"
+"   -writev - only on POSIX builds. in video output modes, send each frame\n"
+"        straight from frame memory with writev() instead of copying it to a\n"
+"        buffer for fwrite(). Windows builds, such as those of the Visual\n"
+"        Studio project, reject it.\n"
+"\n"
+"   -o <file>\n"
+"        in audio and video output modes, write to this file instead of\n"
+"        stdout. the file is preallocated and written through several\n"
+"        sector aligned buffers bypassing the system file cache.\n"
+"\n"
+"   -resume[=seconds  default 10]\n"
+"        with -o, save the progress to <file>.resume at this interval.\n"
+"        if the file exists, drop anything after the last saved frame or\n"
+"        sample and continue from there. the file is removed when the\n"
+"        output is complete.\n"
+"\n"
+"   -byteswap - write 16bit samples of rgb48/rgba rawvideo as big endian.\n"
+"\n"
+"   -vmsplice - on Linux builds, in video output modes to a pipe, hand\n"
+"        frame memory to the pipe with vmsplice() instead of copying it.\n"
+"        the reader has to copy the data out with read(). readers that\n"
+"        splice() or tee() it onward, such as pv or tee, still reference the\n"
+"        frames after they are reused, and get corrupted output.\n"
+"\n"
 "   -dll[=path to avisynth.dll  default \"avisynth\"]\n"
 "        specify which avisynth.dll is used.\n"
 "\n"
@@ -144,7 +303,7 @@ static void parse_opts(int argc, char **argv, Params& p)
         { "y4mb", optional_argument, nullptr, 'b' },
         { "rawvideo", optional_argument, nullptr, 'v' },
         { "info", no_argument, nullptr, 'i' },
-        { "benchmark", no_argument, nullptr, 'B' },
+        { "benchmark", optional_argument, nullptr, 'B' },
 #if 0
         { "x264bdp", optional_argument, nullptr, 'x' },
         { "x264bdt", optional_argument, nullptr, 'y' },
@@ -153,11 +312,36 @@ static void parse_opts(int argc, char **argv, Params& p)
 #endif
         { "dumpyuv", no_argument, nullptr, 'd' }, /* for backward compatibility */
         { "dumptxt", no_argument, nullptr, 'd' },
-        { "dumpprops", no_argument, nullptr, 'j' },
+        { "dumpnpy", required_argument, nullptr, 'O' },
+        { "dumpprops", optional_argument, nullptr, 'j' },
+        { "props", required_argument, nullptr, 'k' },
+        { "propstats", optional_argument, nullptr, 'q' },
         { "filters", no_argument, nullptr, 'f' },
         { "trim", required_argument, nullptr, 'T' },
+        { "frames", required_argument, nullptr, 'L' },
+        { "crop", required_argument, nullptr, 'K' },
+        { "roi", required_argument, nullptr, 'U' },
+        { "planes", required_argument, nullptr, 'V' },
+        { "framestep", required_argument, nullptr, 'E' },
+        { "fields", required_argument, nullptr, 'F' },
+        { "fieldbased", required_argument, nullptr, 'A' },
         { "dll", required_argument, nullptr, 'D' },
         { "y4mbits", required_argument, nullptr, 'Y'},
+        { "prefetch", required_argument, nullptr, 'P' },
+        { "queue", required_argument, nullptr, 'Q' },
+        { "workers", required_argument, nullptr, 'M' },
+        { "chunks", required_argument, nullptr, 'n' },
+        { "chunk-size", required_argument, nullptr, 'z' },
+        { "chunk-index", required_argument, nullptr, 'I' },
+        { "concat", required_argument, nullptr, 'J' },
+        { "framehash", required_argument, nullptr, 'H' },
+        { "compare", required_argument, nullptr, 'G' },
+        { "stats", optional_argument, nullptr, 'X' },
+        { "writev", no_argument, nullptr, 'W' },
+        { "vmsplice", no_argument, nullptr, 'N' },
+        { "o", required_argument, nullptr, 'o' },
+        { "resume", optional_argument, nullptr, 'R' },
+        { "byteswap", no_argument, nullptr, 'S' },
         {nullptr, 0, nullptr, 0}
     };
 
@@ -191,8 +375,29 @@ static void parse_opts(int argc, char **argv, Params& p)
         case 'v':
             p.action = A2PM_ACT_VIDEO;
             p.format_type = FMT_RAWVIDEO;
-            if (optarg && !strncmp(optarg, "vflip", 5))
+            if (!optarg)
+                break;
+            if (!strcmp(optarg, "vflip")) {
                 p.format_type = FMT_RAWVIDEO_VFLIP;
+            } else if (!strcmp(optarg, "nv12")) {
+                p.format_type = FMT_RAWVIDEO_NV12;
+            } else if (!strcmp(optarg, "p010")) {
+                p.format_type = FMT_RAWVIDEO_P010;
+            } else if (!strcmp(optarg, "p016")) {
+                p.format_type = FMT_RAWVIDEO_P016;
+            } else if (!strcmp(optarg, "v210")) {
+                p.format_type = FMT_RAWVIDEO_V210;
+            } else if (!strcmp(optarg, "rgb24")) {
+                p.format_type = FMT_RAWVIDEO_RGB24;
+            } else if (!strcmp(optarg, "bgr24")) {
+                p.format_type = FMT_RAWVIDEO_BGR24;
+            } else if (!strcmp(optarg, "rgb48")) {
+                p.format_type = FMT_RAWVIDEO_RGB48;
+            } else if (!strcmp(optarg, "rgba")) {
+                p.format_type = FMT_RAWVIDEO_RGBA;
+            } else {
+                validate(true, std::format("invalid argument \"{}\".\n\n", optarg));
+            }
             break;
         case 'i':
             p.action = A2PM_ACT_INFO;
@@ -202,6 +407,7 @@ static void parse_opts(int argc, char **argv, Params& p)
             break;
         case 'B':
             p.action = A2PM_ACT_BENCHMARK;
+            p.benchmarkJson = optarg;
             break;
 #if 0
         case 'x':
@@ -233,25 +439,193 @@ static void parse_opts(int argc, char **argv, Params& p)
         case 'd':
             p.action = A2PM_ACT_DUMP_PIXEL_VALUES_AS_TXT;
             break;
+        case 'O':
+            p.action = A2PM_ACT_DUMP_NPY;
+            p.dumpnpy = optarg;
+            break;
         case 'j':
             p.action = A2PM_ACT_DUMP_FRAME_PROPERTIES_AS_JSON;
+            if (optarg) {
+                validate(strcmp(optarg, "json") && strcmp(optarg, "ndjson")
+                            && strcmp(optarg, "columnar"),
+                         std::format("invalid argument \"{}\".\n\n", optarg));
+                p.propsFormat = optarg[0];
+            }
+            break;
+        case 'k':
+            p.props = optarg;
             break;
         case 'T':
             ret = sscanf(optarg, "%d,%d", &p.trimstart, &p.trimend);
             break;
+        case 'L':
+            p.frames = optarg;
+            break;
+        case 'K':
+            ret = sscanf(optarg, "%d,%d,%d,%d", &p.cropleft, &p.croptop,
+                         &p.cropright, &p.cropbottom);
+            validate(ret != 4 || p.cropleft < 0 || p.croptop < 0
+                        || p.cropright < 0 || p.cropbottom < 0,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'U':
+            ret = sscanf(optarg, "%d,%d,%d,%d", &p.roix, &p.roiy,
+                         &p.roiwidth, &p.roiheight);
+            validate(ret != 4 || p.roix < 0 || p.roiy < 0 || p.roiwidth < 1
+                        || p.roiheight < 1,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'V':
+            p.planes = optarg;
+            break;
+        case 'E':
+            ret = sscanf(optarg, "%d", &p.framestep);
+            validate(ret != 1 || p.framestep < 1,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'F':
+            validate(strcmp(optarg, "tff") && strcmp(optarg, "bff"),
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            p.fields = optarg[0] == 't' ? 't' : 'b';
+            break;
+        case 'A':
+            validate(strcmp(optarg, "weave") && strcmp(optarg, "assume"),
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            p.fieldbased = optarg[0];
+            break;
         case 'D':
             p.dll_path = optarg;
             break;
-        case 'Y':
-            ret = sscanf(optarg, "%d", &p.yuv_depth);
-            validate(p.yuv_depth != 9 && p.yuv_depth != 10 && p.yuv_depth != 12
+        case 'Y': {
+            char dither[16] = "none";
+            ret = sscanf(optarg, "%d,%15s", &p.yuv_depth, dither);
+            validate(p.yuv_depth != 8 && p.yuv_depth != 10 && p.yuv_depth != 12
                         && p.yuv_depth != 14 && p.yuv_depth != 16,
                      "invalid bits specified.");
+            if (!strcmp(dither, "ordered")) {
+                p.dither = DITHER_ORDERED;
+            } else if (!strcmp(dither, "errdiff")) {
+                p.dither = DITHER_ERRDIFF;
+            } else {
+                validate(strcmp(dither, "none") != 0, "invalid dither specified.");
+            }
+            break;
+        }
+        case 'P':
+            ret = sscanf(optarg, "%d", &p.prefetch);
+            validate(ret != 1 || p.prefetch < 0,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'Q':
+            ret = sscanf(optarg, "%d", &p.queue);
+            validate(ret != 1 || p.queue < 0,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'M':
+            ret = sscanf(optarg, "%d,%d", &p.workers, &p.chunk);
+            validate(ret < 1 || p.workers < 0 || p.chunk < 1,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'n':
+            ret = sscanf(optarg, "%d", &p.chunks);
+            validate(ret != 1 || p.chunks < 1,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'z':
+            ret = sscanf(optarg, "%d", &p.chunkSize);
+            validate(ret != 1 || p.chunkSize < 1,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'I':
+            ret = sscanf(optarg, "%d", &p.chunkIndex);
+            validate(ret != 1 || p.chunkIndex < 0,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            break;
+        case 'J':
+            p.action = A2PM_ACT_CONCAT;
+            p.manifest = optarg;
+            break;
+        case 'H': {
+            char type[8] = "";
+            ret = sscanf(optarg, "%7[^,]", type);
+            p.framehash = !strcmp(type, "md5") ? FRAMEHASH_MD5 :
+                          !strcmp(type, "crc32") ? FRAMEHASH_CRC32 :
+                          !strcmp(type, "xxh64") ? FRAMEHASH_XXH64 : FRAMEHASH_NONE;
+            validate(p.framehash == FRAMEHASH_NONE,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            if (const char* path = strchr(optarg, ',')) {
+                p.framehashPath = path + 1;
+            }
+            break;
+        }
+        case 'G': {
+            p.action = A2PM_ACT_COMPARE;
+            p.compare = optarg;
+            char* format = strrchr(optarg, ',');
+            if (format && (!strcmp(format, ",csv") || !strcmp(format, ",json"))) {
+                p.compareJson = format[1] == 'j';
+                *format = '\0';
+            }
+            break;
+        }
+        case 'X': {
+            p.action = A2PM_ACT_STATS;
+            if (!optarg) {
+                break;
+            }
+            char format[8] = "";
+            ret = sscanf(optarg, "%7[^,],%d", format, &p.statsBins);
+            validate(ret < 1 || (strcmp(format, "csv") && strcmp(format, "ndjson"))
+                        || p.statsBins < 0 || p.statsBins > 65536,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            p.statsJson = format[0] == 'n';
+            break;
+        }
+        case 'q': {
+            p.action = A2PM_ACT_PROPSTATS;
+            if (!optarg) {
+                break;
+            }
+            char format[8] = "";
+            ret = sscanf(optarg, "%7[^,],%d", format, &p.propStatsDistinct);
+            validate(ret < 1 || (strcmp(format, "text") && strcmp(format, "json"))
+                        || p.propStatsDistinct < 0,
+                     std::format("invalid argument \"{}\".\n\n", optarg));
+            p.propStatsJson = format[0] == 'j';
+            break;
+        }
+        case 'W':
+            p.output = OUT_WRITEV;
+            break;
+        case 'S':
+            p.byteswap = true;
+            break;
+        case 'N':
+            p.output = OUT_VMSPLICE;
+            break;
+        case 'o':
+            p.output_path = optarg;
+            break;
+        case 'R':
+            p.resume = 10;
+            if (optarg) {
+                ret = sscanf(optarg, "%d", &p.resume);
+                validate(ret != 1 || p.resume < 1,
+                         std::format("invalid argument \"{}\".\n\n", optarg));
+            }
             break;
         default:
             break;
         }
     }
+
+    // without an output mode, -framehash is the action.
+    if (p.framehash && p.action == A2PM_ACT_NOTHING) {
+        p.action = A2PM_ACT_FRAMEHASH;
+    }
+    validate(p.framehash && p.action == A2PM_ACT_VIDEO && !p.output_path
+                && !p.framehashPath,
+             "-framehash needs a file when video is written to stdout.\n");
 }
 
 
@@ -275,6 +649,12 @@ int main(int argc, char** argv)
         auto params = Params();
         parse_opts(argc, argv, params);
 
+        if (params.action == A2PM_ACT_CONCAT) {
+            concat_chunks(params.manifest, params.output_path);
+            SetConsoleOutputCP(cp);
+            return 0;
+        }
+
         std::unique_ptr<Avs2PipeMod> a2pm(
             Avs2PipeMod::create(argv[argc - 1], params));
 
@@ -302,12 +682,27 @@ int main(int argc, char** argv)
         case A2PM_ACT_DUMP_PIXEL_VALUES_AS_TXT:
             a2pm->dumpPixValues();
             break;
+        case A2PM_ACT_DUMP_NPY:
+            a2pm->dumpNpy();
+            break;
         case A2PM_ACT_DUMP_FRAME_PROPERTIES_AS_JSON:
             a2pm->dumpFrameProps();
             break;
+        case A2PM_ACT_PROPSTATS:
+            a2pm->propStats();
+            break;
         case A2PM_ACT_FILTERS:
             a2pm->dumpPluginFiltersList();
             break;
+        case A2PM_ACT_FRAMEHASH:
+            a2pm->frameHash();
+            break;
+        case A2PM_ACT_COMPARE:
+            a2pm->compare();
+            break;
+        case A2PM_ACT_STATS:
+            a2pm->stats();
+            break;
         default:
             break;
         }
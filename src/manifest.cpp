@@ -0,0 +1,433 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <vector>
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#define fseek64 _fseeki64
+#define fsync _commit
+#else
+#include <cerrno>
+#include <unistd.h>
+#define fseek64 fseeko
+#endif
+#include "jsonwriter.h"
+#include "manifest.h"
+#include "utils.h"
+
+
+// a JSON string with its quotes.
+static std::string quote(const std::string& s)
+{
+    std::string ret;
+    JsonWriter(ret).value(s);
+    return ret;
+}
+
+
+void write_chunk_entry(const char* path, const chunk_entry_t& e)
+{
+    auto line = std::format(
+        "{{\"file\": {}, \"index\": {}, \"chunks\": {}, \"first\": {}, "
+        "\"last\": {}, \"frames\": {}, \"format\": \"{}\", \"header\": {}, "
+        "\"bytes\": {}, \"xxh64\": \"{:016x}\", \"elapsed\": {:.3f}}}\n",
+        quote(e.file), e.index, e.chunks, e.first, e.last,
+        e.last - e.first + 1, e.format, e.header, e.bytes, e.xxh64,
+        e.elapsed);
+
+    FILE* fp = fopen(path, "wb");
+    validate(!fp, std::format("failed to open {}.\n", path));
+    bool ok = fputs(line.c_str(), fp) != EOF;
+    ok = fclose(fp) == 0 && ok;
+    validate(!ok, std::format("failed to write {}.\n", path));
+    a2pm_log(LOG_INFO, "wrote manifest entry to %s.\n", path);
+}
+
+
+/* a minimal reader for the flat objects written above. the manifest may be
+   the entries put together in any way, e.g. by cat or as a JSON array. */
+
+static std::vector<std::string> split_objects(const std::string& text)
+{
+    std::vector<std::string> objs;
+    size_t start = 0;
+    int depth = 0;
+    bool in_string = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (in_string) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{') {
+            if (depth++ == 0) {
+                start = i;
+            }
+        } else if (c == '}' && depth > 0 && --depth == 0) {
+            objs.push_back(text.substr(start, i - start + 1));
+        }
+    }
+    return objs;
+}
+
+
+static const char* find_value(const std::string& obj, const char* key)
+{
+    const auto name = std::format("\"{}\"", key);
+    for (size_t pos = obj.find(name); pos != std::string::npos;
+            pos = obj.find(name, pos + 1)) {
+        size_t colon = obj.find_first_not_of(" \t\r\n", pos + name.size());
+        if (colon != std::string::npos && obj[colon] == ':') {
+            size_t value = obj.find_first_not_of(" \t\r\n", colon + 1);
+            if (value != std::string::npos) {
+                return obj.c_str() + value;
+            }
+        }
+    }
+    throw std::runtime_error(
+        std::format("manifest entry has no \"{}\".\n{}\n", key, obj));
+}
+
+
+static std::string get_string(const std::string& obj, const char* key)
+{
+    const char* p = find_value(obj, key);
+    validate(*p != '"', std::format("\"{}\" is not a string.\n", key));
+    std::string ret;
+    for (++p; *p && *p != '"'; ++p) {
+        if (*p != '\\' || !p[1]) {
+            ret += *p;
+            continue;
+        }
+        switch (*++p) {
+        case 'b': ret += '\b'; break;
+        case 'f': ret += '\f'; break;
+        case 'n': ret += '\n'; break;
+        case 'r': ret += '\r'; break;
+        case 't': ret += '\t'; break;
+        case 'u': {
+            // only the control characters that quote() writes this way.
+            char* end;
+            const std::string hex(p + 1, strnlen(p + 1, 4));
+            const long c = strtol(hex.c_str(), &end, 16);
+            validate(hex.size() != 4 || *end || c >= 0x80,
+                     std::format("\"{}\" has an unsupported escape.\n", key));
+            ret += static_cast<char>(c);
+            p += 4;
+            break;
+        }
+        default: ret += *p;
+        }
+    }
+    return ret;
+}
+
+
+static int64_t get_int(const std::string& obj, const char* key)
+{
+    const char* p = find_value(obj, key);
+    char* end;
+    int64_t ret = strtoll(p, &end, 10);
+    validate(end == p, std::format("\"{}\" is not a number.\n", key));
+    return ret;
+}
+
+
+static std::string read_text(const char* path)
+{
+    FILE* fp = fopen(path, "rb");
+    validate(!fp, std::format("failed to open {}.\n", path));
+    std::string text;
+    char buff[4096];
+    for (size_t n; (n = fread(buff, 1, sizeof(buff), fp)) > 0;) {
+        text.append(buff, n);
+    }
+    fclose(fp);
+    return text;
+}
+
+
+static chunk_entry_t parse_entry(const std::string& obj)
+{
+    chunk_entry_t e;
+    e.file = get_string(obj, "file");
+    e.index = static_cast<int>(get_int(obj, "index"));
+    e.chunks = static_cast<int>(get_int(obj, "chunks"));
+    e.first = static_cast<int>(get_int(obj, "first"));
+    e.last = static_cast<int>(get_int(obj, "last"));
+    e.format = get_string(obj, "format");
+    e.header = get_int(obj, "header");
+    e.bytes = get_int(obj, "bytes");
+    e.xxh64 = strtoull(get_string(obj, "xxh64").c_str(), nullptr, 16);
+    e.elapsed = strtod(find_value(obj, "elapsed"), nullptr);
+    return e;
+}
+
+
+static std::string read_header(FILE* fp, uint64_t size, const std::string& path)
+{
+    std::string ret(size, '\0');
+    validate(fread(ret.data(), 1, size, fp) != size,
+             std::format("failed to read {}.\n", path));
+    return ret;
+}
+
+
+// appends size bytes of 'in' from offset to 'out'. returns true if the
+// kernel copied all of them.
+static bool copy_range(FILE* in, uint64_t offset, uint64_t size, FILE* out,
+                       std::vector<char>& buff, const std::string& path)
+{
+    uint64_t done = 0;
+#if defined(__linux__)
+    // copy_file_range does not bring the data into this process, and lets
+    // filesystems that support it share the extents instead of copying them.
+    // it fails for pipes or across some filesystems, then read/write is used.
+    validate(fflush(out) != 0, "failed to write the output.\n");
+    loff_t off = offset;
+    while (done < size) {
+        ssize_t ret = copy_file_range(fileno(in), &off, fileno(out), nullptr,
+                                      size - done, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ret <= 0) {
+            break;
+        }
+        done += ret;
+    }
+    if (done == size) {
+        return true;
+    }
+#endif
+    validate(fseek64(in, offset + done, SEEK_SET) != 0,
+             std::format("failed to seek {}.\n", path));
+    while (done < size) {
+        size_t count = static_cast<size_t>(
+            std::min<uint64_t>(buff.size(), size - done));
+        validate(fread(buff.data(), 1, count, in) != count,
+                 std::format("failed to read {}.\n", path));
+        validate(fwrite(buff.data(), 1, count, out) != count,
+                 "failed to write the output.\n");
+        done += count;
+    }
+    validate(fflush(out) != 0, "failed to write the output.\n");
+    return false;
+}
+
+
+void concat_chunks(const char* manifest, const char* output_path)
+{
+    namespace fs = std::filesystem;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<chunk_entry_t> entries;
+    for (const auto& obj : split_objects(read_text(manifest))) {
+        entries.push_back(parse_entry(obj));
+    }
+    validate(entries.empty(), std::format("no entries found in {}.\n", manifest));
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.index < b.index; });
+
+    // every chunk must be there once, and together they must cover the clip
+    // without gaps or overlaps.
+    const auto& head = entries[0];
+    const fs::path dir = fs::path(manifest).parent_path();
+    validate(static_cast<int>(entries.size()) != head.chunks,
+             std::format("{} has {} entries for {} chunks.\n", manifest,
+                         entries.size(), head.chunks));
+    std::vector<fs::path> paths;
+    int next = 0;
+    uint64_t total = 0;
+    for (int i = 0; i < head.chunks; ++i) {
+        const auto& e = entries[i];
+        validate(e.index != i || e.chunks != head.chunks,
+                 std::format("chunk {} is missing or duplicated.\n", i));
+        validate(e.format != head.format || e.header != head.header,
+                 std::format("chunk {} is not in the format of chunk 0.\n", i));
+        validate(e.first != next || e.last < e.first,
+                 std::format("chunk {} has frames {}-{}, expected it to start "
+                             "at {}.\n", i, e.first, e.last, next));
+        next = e.last + 1;
+
+        paths.push_back(dir / fs::path(e.file));
+        std::error_code ec;
+        uint64_t size = fs::file_size(paths.back(), ec);
+        validate(ec || size != e.bytes,
+                 std::format("{} is not {} bytes as in the manifest.\n",
+                             paths.back().string(), e.bytes));
+        total += i == 0 ? e.bytes : e.bytes - e.header;
+    }
+
+    FILE* out = stdout;
+    if (output_path) {
+        out = fopen(output_path, "wb");
+        validate(!out, std::format("failed to open {}.\n", output_path));
+    } else {
+#if defined(_WIN32)
+        validate(_setmode(_fileno(stdout), _O_BINARY) == -1,
+                 "cannot switch stdout to binary mode.\n");
+#endif
+    }
+    a2pm_log(LOG_INFO, "concatenating %d chunks of %d frames, %s.\n",
+             head.chunks, next, head.format.c_str());
+
+    std::vector<char> copy_buff(1 << 20);
+    std::string header;
+    int in_kernel = 0;
+    for (int i = 0; i < head.chunks; ++i) {
+        const auto& e = entries[i];
+        const auto path = paths[i].string();
+        FILE* in = fopen(path.c_str(), "rb");
+        validate(!in, std::format("failed to open {}.\n", path));
+        // the stream header is written once. the others must be the same.
+        uint64_t skip = 0;
+        if (e.header > 0) {
+            auto h = read_header(in, e.header, path);
+            if (i == 0) {
+                header = h;
+            } else {
+                validate(h != header,
+                         std::format("the header of {} differs from chunk 0.\n",
+                                     path));
+                skip = e.header;
+            }
+        }
+        in_kernel += copy_range(in, skip, e.bytes - skip, out, copy_buff, path);
+        fclose(in);
+    }
+    if (output_path) {
+        validate(fclose(out) != 0, "failed to write the output.\n");
+    }
+
+    const double sec = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    a2pm_log(LOG_INFO, "wrote %.1f MB in %.3f sec, %d of %d chunks copied "
+             "in the kernel.\n", total / 1048576.0, sec, in_kernel, head.chunks);
+}
+
+
+static int64_t now_usec()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+        steady_clock::now().time_since_epoch()).count();
+}
+
+
+Checkpoint::Checkpoint(const char* output_path, int interval_sec, uint64_t t) :
+    path(std::format("{}.resume", output_path)),
+    interval(interval_sec * INT64_C(1000000)), last(now_usec()), total(t),
+    header(0), resumed(false), done(0), bytes(0)
+{
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return;
+    }
+    const auto objs = split_objects(read_text(path.c_str()));
+    validate(objs.size() != 1, std::format("{} is broken.\n", path));
+    const auto& obj = objs[0];
+    validate(static_cast<uint64_t>(get_int(obj, "total")) != total,
+             std::format("{} is for a clip of {} frames or samples, not {}.\n",
+                         path, get_int(obj, "total"), total));
+    done = get_int(obj, "done");
+    bytes = get_int(obj, "bytes");
+    header = strtoull(get_string(obj, "header").c_str(), nullptr, 16);
+    validate(done > total || !hash.load(get_string(obj, "xxh64")),
+             std::format("{} is broken.\n", path));
+    if (done == 0) {
+        // nothing to keep, start over.
+        bytes = 0;
+        hash = XXH64();
+        return;
+    }
+    validate(done == total,
+             std::format("{} is for an output that is already complete. "
+                         "remove it to write the output again.\n", path));
+    resumed = true;
+    a2pm_log(LOG_INFO, "resuming %s after %" PRIu64 " of %" PRIu64
+             " frames/samples, at %" PRIu64 " bytes.\n",
+             output_path, done, total, bytes);
+}
+
+
+void Checkpoint::setHeader(const void* data, size_t size)
+{
+    XXH64 h;
+    h.update(data, size);
+    validate(resumed && h.digest() != header,
+             std::format("the stream header differs from the one in {}. the "
+                         "clip or the options have changed.\n", path));
+    header = h.digest();
+}
+
+
+bool Checkpoint::due() const
+{
+    return now_usec() - last >= interval;
+}
+
+
+// written to a temporary file first, so that a checkpoint is never seen
+// half written, and synced before the rename, so that it is never seen
+// empty after a crash.
+void Checkpoint::save(uint64_t d, uint64_t b, const XXH64& h)
+{
+    done = d;
+    bytes = b;
+    hash = h;
+    auto line = std::format(
+        "{{\"done\": {}, \"total\": {}, \"bytes\": {}, \"header\": "
+        "\"{:016x}\", \"xxh64\": \"{}\"}}\n",
+        done, total, bytes, header, hash.save());
+
+    const auto tmp = path + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    validate(!fp, std::format("failed to open {}.\n", tmp));
+    bool ok = fputs(line.c_str(), fp) != EOF && fflush(fp) == 0
+           && fsync(fileno(fp)) == 0;
+    ok = fclose(fp) == 0 && ok;
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    validate(!ok || ec, std::format("failed to write {}.\n", path));
+    last = now_usec();
+}
+
+
+void Checkpoint::remove()
+{
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
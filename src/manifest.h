@@ -0,0 +1,77 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_MANIFEST_H
+#define A2PM_MANIFEST_H
+
+#include <cstdint>
+#include <string>
+#include "hash.h"
+
+
+// one segment of a clip rendered by -chunks/-chunk-size.
+struct chunk_entry_t {
+    std::string file;   // relative to the directory of the manifest
+    int index;
+    int chunks;
+    int first;          // frame numbers in the clip after -trim
+    int last;
+    std::string format; // "y4m" or "raw"
+    uint64_t header;    // bytes of the stream header, skipped when appended
+    uint64_t bytes;
+    uint64_t xxh64;     // of all the bytes of the file
+    double elapsed;
+};
+
+// writes the entry as a line of JSON, to the file 'path'.
+void write_chunk_entry(const char* path, const chunk_entry_t& entry);
+
+// checks the entries found in 'manifest' and writes their files in order to
+// output_path, or stdout if it is nullptr.
+void concat_chunks(const char* manifest, const char* output_path);
+
+
+// -resume. the progress of an output file is kept in <output>.resume until
+// the file is complete.
+class Checkpoint {
+    std::string path;
+    int64_t interval;   // in usec
+    int64_t last;
+    uint64_t total;
+    uint64_t header;
+public:
+    bool resumed;       // true if the file is continued from a checkpoint
+    uint64_t done;      // frames or samples in the file
+    uint64_t bytes;
+    XXH64 hash;         // of the bytes of the file
+    // total is the number of frames or samples of the complete file.
+    Checkpoint(const char* output_path, int interval_sec, uint64_t total);
+    // the stream header of this run must be the one the file starts with.
+    void setHeader(const void* data, size_t size);
+    // true if the last checkpoint is older than the interval.
+    bool due() const;
+    // the output must have been synced up to 'bytes'.
+    void save(uint64_t done, uint64_t bytes, const XXH64& hash);
+    void remove();
+};
+
+#endif
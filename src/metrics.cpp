@@ -0,0 +1,506 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <cmath>
+#include <emmintrin.h>
+#include <format>
+#include <limits>
+#include "metrics.h"
+#include "utils.h"
+
+
+/* SSE2 row kernels */
+
+template <typename T>
+double sse_row_sse2(const T* a, const T* b, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    if constexpr (std::is_floating_point_v<T>) {
+        const int w4 = width & ~3;
+        __m128d sum = _mm_setzero_pd();
+        for (int x = 0; x < w4; x += 4) {
+            __m128 d = _mm_sub_ps(_mm_loadu_ps(a + x), _mm_loadu_ps(b + x));
+            d = _mm_mul_ps(d, d);
+            sum = _mm_add_pd(sum, _mm_cvtps_pd(d));
+            sum = _mm_add_pd(sum, _mm_cvtps_pd(_mm_movehl_ps(d, d)));
+        }
+        alignas(16) double s[2];
+        _mm_store_pd(s, sum);
+        return s[0] + s[1] + sse_row_c(a, b, w4, width);
+    } else if constexpr (sizeof(T) == 1) {
+        // 32bit lanes are enough for rows of up to 256k samples.
+        const int w16 = width & ~15;
+        __m128i sum = zero;
+        for (int x = 0; x < w16; x += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+            __m128i d = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+            __m128i lo = _mm_unpacklo_epi8(d, zero);
+            __m128i hi = _mm_unpackhi_epi8(d, zero);
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(lo, lo));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(hi, hi));
+        }
+        alignas(16) uint32_t s[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(s), sum);
+        uint64_t total = static_cast<uint64_t>(s[0]) + s[1] + s[2] + s[3];
+        return static_cast<double>(total) + sse_row_c(a, b, w16, width);
+    } else {
+        const int w8 = width & ~7;
+        __m128i sum = zero;
+        for (int x = 0; x < w8; x += 8) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+            __m128i d = _mm_or_si128(_mm_subs_epu16(va, vb), _mm_subs_epu16(vb, va));
+            // the squares need all 32 bits, they are summed in 64bit lanes.
+            __m128i lo = _mm_mullo_epi16(d, d);
+            __m128i hi = _mm_mulhi_epu16(d, d);
+            __m128i p0 = _mm_unpacklo_epi16(lo, hi);
+            __m128i p1 = _mm_unpackhi_epi16(lo, hi);
+            sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(p0, zero));
+            sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(p0, zero));
+            sum = _mm_add_epi64(sum, _mm_unpacklo_epi32(p1, zero));
+            sum = _mm_add_epi64(sum, _mm_unpackhi_epi32(p1, zero));
+        }
+        alignas(16) uint64_t s[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(s), sum);
+        return static_cast<double>(s[0] + s[1]) + sse_row_c(a, b, w8, width);
+    }
+}
+
+template double sse_row_sse2<uint8_t>(const uint8_t*, const uint8_t*, int);
+template double sse_row_sse2<uint16_t>(const uint16_t*, const uint16_t*, int);
+template double sse_row_sse2<float>(const float*, const float*, int);
+
+
+template <typename T>
+static inline void load4_pd(const T* p, __m128d& lo, __m128d& hi)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        __m128 x = _mm_loadu_ps(p);
+        lo = _mm_cvtps_pd(x);
+        hi = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+    } else {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i x;
+        if constexpr (sizeof(T) == 1) {
+            x = _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p));
+            x = _mm_unpacklo_epi8(x, zero);
+        } else {
+            x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        }
+        x = _mm_unpacklo_epi16(x, zero);
+        lo = _mm_cvtepi32_pd(x);
+        hi = _mm_cvtepi32_pd(_mm_srli_si128(x, 8));
+    }
+}
+
+
+// lo holds the sums of columns 0 and 1, hi of 2 and 3. returns the sums of
+// x and y.
+static inline __m128d add_columns(__m128d xlo, __m128d xhi, __m128d ylo,
+                                  __m128d yhi)
+{
+    __m128d lo = _mm_add_pd(_mm_unpacklo_pd(xlo, ylo), _mm_unpackhi_pd(xlo, ylo));
+    __m128d hi = _mm_add_pd(_mm_unpacklo_pd(xhi, yhi), _mm_unpackhi_pd(xhi, yhi));
+    return _mm_add_pd(lo, hi);
+}
+
+
+template <typename T>
+void ssim_4x4_row_sse2(const T* a, int apitch, const T* b, int bpitch,
+                       double* sums, int blocks)
+{
+    for (int i = 0; i < blocks; ++i) {
+        __m128d s1[2], s2[2], ss[2], s12[2];
+        for (int h = 0; h < 2; ++h) {
+            s1[h] = s2[h] = ss[h] = s12[h] = _mm_setzero_pd();
+        }
+        for (int y = 0; y < 4; ++y) {
+            __m128d va[2], vb[2];
+            load4_pd(a + y * apitch + 4 * i, va[0], va[1]);
+            load4_pd(b + y * bpitch + 4 * i, vb[0], vb[1]);
+            for (int h = 0; h < 2; ++h) {
+                s1[h] = _mm_add_pd(s1[h], va[h]);
+                s2[h] = _mm_add_pd(s2[h], vb[h]);
+                __m128d sq = _mm_add_pd(_mm_mul_pd(va[h], va[h]),
+                                        _mm_mul_pd(vb[h], vb[h]));
+                ss[h] = _mm_add_pd(ss[h], sq);
+                s12[h] = _mm_add_pd(s12[h], _mm_mul_pd(va[h], vb[h]));
+            }
+        }
+        _mm_storeu_pd(sums + 4 * i, add_columns(s1[0], s1[1], s2[0], s2[1]));
+        _mm_storeu_pd(sums + 4 * i + 2, add_columns(ss[0], ss[1], s12[0], s12[1]));
+    }
+}
+
+template void ssim_4x4_row_sse2<uint8_t>(
+    const uint8_t*, int, const uint8_t*, int, double*, int);
+template void ssim_4x4_row_sse2<uint16_t>(
+    const uint16_t*, int, const uint16_t*, int, double*, int);
+template void ssim_4x4_row_sse2<float>(
+    const float*, int, const float*, int, double*, int);
+
+
+template <typename T>
+void stats_row_sse2(const T* p, int width, row_stats_t& s)
+{
+    const __m128i zero = _mm_setzero_si128();
+    if constexpr (std::is_floating_point_v<T>) {
+        const int w4 = width & ~3;
+        if (w4 > 0) {
+            __m128 mn = _mm_loadu_ps(p);
+            __m128 mx = mn;
+            __m128d sum = _mm_setzero_pd();
+            __m128d sq = _mm_setzero_pd();
+            for (int x = 0; x < w4; x += 4) {
+                __m128 v = _mm_loadu_ps(p + x);
+                mn = _mm_min_ps(mn, v);
+                mx = _mm_max_ps(mx, v);
+                __m128d lo = _mm_cvtps_pd(v);
+                __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+                sum = _mm_add_pd(sum, _mm_add_pd(lo, hi));
+                sq = _mm_add_pd(sq, _mm_add_pd(_mm_mul_pd(lo, lo), _mm_mul_pd(hi, hi)));
+            }
+            alignas(16) float fmin[4], fmax[4];
+            alignas(16) double dsum[2], dsq[2];
+            _mm_store_ps(fmin, mn);
+            _mm_store_ps(fmax, mx);
+            _mm_store_pd(dsum, sum);
+            _mm_store_pd(dsq, sq);
+            for (int i = 0; i < 4; ++i) {
+                s.min = std::min(s.min, static_cast<double>(fmin[i]));
+                s.max = std::max(s.max, static_cast<double>(fmax[i]));
+            }
+            s.sum += dsum[0] + dsum[1];
+            s.sumsq += dsq[0] + dsq[1];
+        }
+        stats_row_c(p, w4, width, s);
+    } else if constexpr (sizeof(T) == 1) {
+        const int w16 = width & ~15;
+        if (w16 > 0) {
+            __m128i mn = _mm_set1_epi8(-1);
+            __m128i mx = zero;
+            __m128i sum = zero;
+            __m128i sq = zero;
+            for (int x = 0; x < w16; x += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + x));
+                mn = _mm_min_epu8(mn, v);
+                mx = _mm_max_epu8(mx, v);
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(v, zero));
+                __m128i lo = _mm_unpacklo_epi8(v, zero);
+                __m128i hi = _mm_unpackhi_epi8(v, zero);
+                sq = _mm_add_epi32(sq, _mm_madd_epi16(lo, lo));
+                sq = _mm_add_epi32(sq, _mm_madd_epi16(hi, hi));
+            }
+            alignas(16) uint8_t bmin[16], bmax[16];
+            alignas(16) uint64_t qsum[2];
+            alignas(16) uint32_t dsq[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(bmin), mn);
+            _mm_store_si128(reinterpret_cast<__m128i*>(bmax), mx);
+            _mm_store_si128(reinterpret_cast<__m128i*>(qsum), sum);
+            _mm_store_si128(reinterpret_cast<__m128i*>(dsq), sq);
+            s.min = std::min(s.min, static_cast<double>(*std::min_element(bmin, bmin + 16)));
+            s.max = std::max(s.max, static_cast<double>(*std::max_element(bmax, bmax + 16)));
+            s.sum += static_cast<double>(qsum[0] + qsum[1]);
+            s.sumsq += static_cast<double>(static_cast<uint64_t>(dsq[0]) + dsq[1] + dsq[2] + dsq[3]);
+        }
+        stats_row_c(p, w16, width, s);
+    } else {
+        // min/max_epu16 are SSE4.1, the samples are compared as signed
+        // with the sign bit flipped.
+        const __m128i sign = _mm_set1_epi16(-32768);
+        const int w8 = width & ~7;
+        if (w8 > 0) {
+            __m128i mn = _mm_set1_epi16(32767);
+            __m128i mx = sign;
+            __m128i sum = zero;
+            __m128i sq = zero;
+            for (int x = 0; x < w8; x += 8) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + x));
+                __m128i b = _mm_xor_si128(v, sign);
+                mn = _mm_min_epi16(mn, b);
+                mx = _mm_max_epi16(mx, b);
+                sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(v, zero));
+                sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(v, zero));
+                __m128i lo = _mm_mullo_epi16(v, v);
+                __m128i hi = _mm_mulhi_epu16(v, v);
+                __m128i p0 = _mm_unpacklo_epi16(lo, hi);
+                __m128i p1 = _mm_unpackhi_epi16(lo, hi);
+                sq = _mm_add_epi64(sq, _mm_unpacklo_epi32(p0, zero));
+                sq = _mm_add_epi64(sq, _mm_unpackhi_epi32(p0, zero));
+                sq = _mm_add_epi64(sq, _mm_unpacklo_epi32(p1, zero));
+                sq = _mm_add_epi64(sq, _mm_unpackhi_epi32(p1, zero));
+            }
+            alignas(16) uint16_t wmin[8], wmax[8];
+            alignas(16) uint32_t dsum[4];
+            alignas(16) uint64_t qsq[2];
+            _mm_store_si128(reinterpret_cast<__m128i*>(wmin), _mm_xor_si128(mn, sign));
+            _mm_store_si128(reinterpret_cast<__m128i*>(wmax), _mm_xor_si128(mx, sign));
+            _mm_store_si128(reinterpret_cast<__m128i*>(dsum), sum);
+            _mm_store_si128(reinterpret_cast<__m128i*>(qsq), sq);
+            s.min = std::min(s.min, static_cast<double>(*std::min_element(wmin, wmin + 8)));
+            s.max = std::max(s.max, static_cast<double>(*std::max_element(wmax, wmax + 8)));
+            s.sum += static_cast<double>(static_cast<uint64_t>(dsum[0]) + dsum[1] + dsum[2] + dsum[3]);
+            s.sumsq += static_cast<double>(qsq[0] + qsq[1]);
+        }
+        stats_row_c(p, w8, width, s);
+    }
+}
+
+template void stats_row_sse2<uint8_t>(const uint8_t*, int, row_stats_t&);
+template void stats_row_sse2<uint16_t>(const uint16_t*, int, row_stats_t&);
+template void stats_row_sse2<float>(const float*, int, row_stats_t&);
+
+
+/* planes */
+
+// s are the sums of an 8x8 window. the constants are the ones of x264 and
+// ffmpeg, so that the results can be compared with theirs.
+static inline double ssim_end(const double* s, double c1, double c2)
+{
+    const double vars = s[2] * 64 - s[0] * s[0] - s[1] * s[1];
+    const double covar = s[3] * 64 - s[0] * s[1];
+    return (2 * s[0] * s[1] + c1) * (2 * covar + c2)
+         / ((s[0] * s[0] + s[1] * s[1] + c1) * (vars + c2));
+}
+
+
+template <typename T>
+static inline const T* row_ptr(const plane_t& p, int y)
+{
+    return reinterpret_cast<const T*>(p.ptr + static_cast<int64_t>(y) * p.pitch);
+}
+
+
+// SSIM is the mean of the 8x8 windows at every 4 pixels.
+template <typename T>
+plane_metric_t compare_plane(const plane_t& a, const plane_t& b, int bits)
+{
+    const int width = a.rowsize / static_cast<int>(sizeof(T));
+    const int height = a.height;
+    const bool avx2 = has_avx2();
+    auto sse_row = avx2 ? sse_row_avx2<T> : sse_row_sse2<T>;
+    auto ssim_row = avx2 ? ssim_4x4_row_avx2<T> : ssim_4x4_row_sse2<T>;
+
+    plane_metric_t m = { 0.0, 0.0, static_cast<int64_t>(width) * height };
+    for (int y = 0; y < height; ++y) {
+        m.sse += sse_row(row_ptr<T>(a, y), row_ptr<T>(b, y), width);
+    }
+
+    const int bw = width / 4;
+    const int bh = height / 4;
+    if (bw < 2 || bh < 2) {
+        m.ssim = std::numeric_limits<double>::quiet_NaN();
+        return m;
+    }
+    const double peak = bits == 32 ? 1.0 : (1 << bits) - 1;
+    const double c1 = .01 * .01 * peak * peak * 64;
+    const double c2 = .03 * .03 * peak * peak * 64 * 63;
+    const int apitch = a.pitch / static_cast<int>(sizeof(T));
+    const int bpitch = b.pitch / static_cast<int>(sizeof(T));
+
+    std::vector<double> rows(8 * static_cast<size_t>(bw));
+    double* prev = rows.data();
+    double* cur = prev + 4 * bw;
+    double total = 0.0;
+    for (int by = 0; by < bh; ++by) {
+        ssim_row(row_ptr<T>(a, 4 * by), apitch, row_ptr<T>(b, 4 * by), bpitch,
+                 cur, bw);
+        for (int bx = 0; by > 0 && bx < bw - 1; ++bx) {
+            const double* p = prev + 4 * bx;
+            const double* c = cur + 4 * bx;
+            double s[4];
+            for (int k = 0; k < 4; ++k) {
+                s[k] = p[k] + p[k + 4] + c[k] + c[k + 4];
+            }
+            total += ssim_end(s, c1, c2);
+        }
+        std::swap(prev, cur);
+    }
+    m.ssim = total / (static_cast<double>(bw - 1) * (bh - 1));
+    return m;
+}
+
+template plane_metric_t compare_plane<uint8_t>(const plane_t&, const plane_t&, int);
+template plane_metric_t compare_plane<uint16_t>(const plane_t&, const plane_t&, int);
+template plane_metric_t compare_plane<float>(const plane_t&, const plane_t&, int);
+
+
+/* report */
+
+static double get_psnr(double sse, int64_t pixels, double peak)
+{
+    if (sse <= 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    return 10.0 * std::log10(peak * peak * pixels / sse);
+}
+
+
+// JSON has no inf and nan.
+static std::string to_string(double v, bool json)
+{
+    if (std::isfinite(v)) {
+        return std::format("{:.6f}", v);
+    }
+    return json ? "null" : std::isnan(v) ? "nan" : "inf";
+}
+
+
+CompareReport::
+CompareReport(const char* path, bool j, const std::vector<std::string>& n,
+              int bits) :
+    fp(stdout), json(j), peak(bits == 32 ? 1.0 : (1 << bits) - 1), names(n),
+    frames(0)
+{
+    if (path) {
+        fp = fopen(path, "w");
+        validate(!fp, std::format("failed to open {}.\n", path));
+    }
+    const double inf = std::numeric_limits<double>::infinity();
+    totals.assign(names.size() + 1, { 0.0, 0, 0.0, 0, inf, -1, inf, -1 });
+
+    if (json) {
+        fputs("{\"frames\": [", fp);
+        return;
+    }
+    std::string line = "frame";
+    for (const auto& name : names) {
+        line += ",psnr_" + name;
+    }
+    line += ",psnr";
+    for (const auto& name : names) {
+        line += ",ssim_" + name;
+    }
+    line += ",ssim\n";
+    fputs(line.c_str(), fp);
+}
+
+
+CompareReport::~CompareReport()
+{
+    if (fp != stdout) {
+        fclose(fp);
+    }
+}
+
+
+// the values of all planes are the PSNR of the sum of the squared
+// differences, and the mean of the SSIMs weighted by the size of the planes,
+// as ffmpeg does.
+void CompareReport::add(int n, const plane_metric_t* planes)
+{
+    const size_t num = names.size();
+    std::vector<double> psnr(num + 1), ssim(num + 1);
+    double sse = 0.0, weighted = 0.0, weight = 0.0;
+    int64_t pixels = 0;
+    for (size_t p = 0; p < num; ++p) {
+        psnr[p] = get_psnr(planes[p].sse, planes[p].pixels, peak);
+        ssim[p] = planes[p].ssim;
+        sse += planes[p].sse;
+        pixels += planes[p].pixels;
+        if (!std::isnan(ssim[p])) {
+            weighted += ssim[p] * planes[p].pixels;
+            weight += static_cast<double>(planes[p].pixels);
+        }
+    }
+    psnr[num] = get_psnr(sse, pixels, peak);
+    ssim[num] = weight > 0 ? weighted / weight
+                           : std::numeric_limits<double>::quiet_NaN();
+
+    for (size_t p = 0; p <= num; ++p) {
+        total_t& t = totals[p];
+        t.sse += p < num ? planes[p].sse : sse;
+        t.pixels += p < num ? planes[p].pixels : pixels;
+        if (t.minPsnrFrame < 0 || psnr[p] < t.minPsnr) {
+            t.minPsnr = psnr[p];
+            t.minPsnrFrame = n;
+        }
+        if (!std::isnan(ssim[p])) {
+            t.ssim += ssim[p];
+            ++t.ssimFrames;
+            if (t.minSsimFrame < 0 || ssim[p] < t.minSsim) {
+                t.minSsim = ssim[p];
+                t.minSsimFrame = n;
+            }
+        }
+    }
+
+    std::string line;
+    if (json) {
+        auto object = [&](const std::vector<double>& v) {
+            std::string s = "{";
+            for (size_t p = 0; p <= num; ++p) {
+                s += std::format("{}\"{}\": {}", p > 0 ? ", " : "",
+                                 p < num ? names[p] : "all", to_string(v[p], true));
+            }
+            return s + "}";
+        };
+        line = std::format("{}\n  {{\"frame\": {}, \"psnr\": {}, \"ssim\": {}}}",
+                           frames > 0 ? "," : "", n, object(psnr), object(ssim));
+    } else {
+        line = std::format("{}", n);
+        for (double v : psnr) {
+            line += "," + to_string(v, false);
+        }
+        for (double v : ssim) {
+            line += "," + to_string(v, false);
+        }
+        line += "\n";
+    }
+    fputs(line.c_str(), fp);
+    ++frames;
+}
+
+
+// the average PSNR is the one of the mean squared error of all frames.
+void CompareReport::finish()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::string summary = std::format("\n], \"summary\": {{\"frames\": {}",
+                                      frames);
+    for (size_t p = 0; p < totals.size(); ++p) {
+        const total_t& t = totals[p];
+        const std::string& name = p < names.size() ? names[p] : "all";
+        const double psnr = get_psnr(t.sse, t.pixels, peak);
+        const double ssim = t.ssimFrames > 0 ? t.ssim / t.ssimFrames : nan;
+
+        a2pm_log(LOG_INFO, "%-4s PSNR %s (min %s at %d), SSIM %s (min %s at %d)\n",
+                 name.c_str(), to_string(psnr, false).c_str(),
+                 to_string(t.minPsnr, false).c_str(), t.minPsnrFrame,
+                 to_string(ssim, false).c_str(),
+                 to_string(t.ssimFrames > 0 ? t.minSsim : nan, false).c_str(),
+                 t.minSsimFrame);
+
+        summary += std::format(
+            ", \"{}\": {{\"psnr\": {}, \"psnr_min\": {}, \"psnr_min_frame\": {}, "
+            "\"ssim\": {}, \"ssim_min\": {}, \"ssim_min_frame\": {}}}",
+            name, to_string(psnr, true), to_string(t.minPsnr, true),
+            t.minPsnrFrame, to_string(ssim, true),
+            to_string(t.ssimFrames > 0 ? t.minSsim : nan, true), t.minSsimFrame);
+    }
+    if (json) {
+        fputs((summary + "}}\n").c_str(), fp);
+    }
+    fflush(fp);
+}
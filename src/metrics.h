@@ -0,0 +1,162 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_METRICS_H
+#define A2PM_METRICS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "output.h"
+
+
+// difference of one plane of two frames.
+struct plane_metric_t {
+    double sse;         // sum of squared differences
+    double ssim;        // NaN if the plane is smaller than 8x8
+    int64_t pixels;
+};
+
+// T is the sample type, bits the bit depth of the samples (32 for float).
+template <typename T>
+plane_metric_t compare_plane(const plane_t& a, const plane_t& b, int bits);
+
+
+// writes the metrics of every frame as CSV or JSON to stdout or the file,
+// and the summary at the end.
+class CompareReport {
+    struct total_t {
+        double sse;
+        int64_t pixels;
+        double ssim;
+        int ssimFrames;
+        double minPsnr;
+        int minPsnrFrame;
+        double minSsim;
+        int minSsimFrame;
+    };
+    FILE* fp;
+    bool json;
+    double peak;
+    std::vector<std::string> names;
+    std::vector<total_t> totals;    // planes, then all of them
+    int frames;
+public:
+    CompareReport(const char* path, bool json,
+                  const std::vector<std::string>& names, int bits);
+    ~CompareReport();
+    void add(int n, const plane_metric_t* planes);
+    void finish();
+};
+
+
+/* row kernels */
+
+// sum of squared differences. the squares of float samples are summed as
+// double.
+template <typename T>
+static inline double sse_row_c(const T* a, const T* b, int start, int width)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        double sum = 0.0;
+        for (int x = start; x < width; ++x) {
+            float d = a[x] - b[x];
+            sum += d * d;
+        }
+        return sum;
+    } else {
+        uint64_t sum = 0;
+        for (int x = start; x < width; ++x) {
+            int64_t d = static_cast<int64_t>(a[x]) - b[x];
+            sum += static_cast<uint64_t>(d * d);
+        }
+        return static_cast<double>(sum);
+    }
+}
+
+// sum of a, b, a*a + b*b and a*b of each 4x4 block of 4 rows. pitches are
+// in samples. the columns are added as (0 + 1) + (2 + 3), as the SIMD
+// versions do.
+template <typename T>
+static inline void
+ssim_4x4_row_c(const T* a, int apitch, const T* b, int bpitch, double* sums,
+               int start, int blocks)
+{
+    for (int i = start; i < blocks; ++i) {
+        double col[4][4] = {};
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                double va = a[y * apitch + 4 * i + x];
+                double vb = b[y * bpitch + 4 * i + x];
+                col[0][x] += va;
+                col[1][x] += vb;
+                col[2][x] += va * va + vb * vb;
+                col[3][x] += va * vb;
+            }
+        }
+        for (int s = 0; s < 4; ++s) {
+            sums[4 * i + s] = (col[s][0] + col[s][1]) + (col[s][2] + col[s][3]);
+        }
+    }
+}
+
+// minimum, maximum, sum and sum of squares of the samples.
+struct row_stats_t {
+    double min;
+    double max;
+    double sum;
+    double sumsq;
+};
+
+template <typename T>
+static inline void stats_row_c(const T* p, int start, int width, row_stats_t& s)
+{
+    for (int x = start; x < width; ++x) {
+        double v = p[x];
+        s.min = std::min(s.min, v);
+        s.max = std::max(s.max, v);
+        s.sum += v;
+        s.sumsq += v * v;
+    }
+}
+
+template <typename T>
+double sse_row_sse2(const T* a, const T* b, int width);
+template <typename T>
+double sse_row_avx2(const T* a, const T* b, int width);
+
+template <typename T>
+void ssim_4x4_row_sse2(const T* a, int apitch, const T* b, int bpitch,
+                       double* sums, int blocks);
+template <typename T>
+void ssim_4x4_row_avx2(const T* a, int apitch, const T* b, int bpitch,
+                       double* sums, int blocks);
+
+template <typename T>
+void stats_row_sse2(const T* p, int width, row_stats_t& s);
+template <typename T>
+void stats_row_avx2(const T* p, int width, row_stats_t& s);
+
+#endif
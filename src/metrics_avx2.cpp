@@ -0,0 +1,256 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <immintrin.h>
+#include "metrics.h"
+
+
+template <typename T>
+double sse_row_avx2(const T* a, const T* b, int width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    if constexpr (std::is_floating_point_v<T>) {
+        const int w8 = width & ~7;
+        __m256d sum = _mm256_setzero_pd();
+        for (int x = 0; x < w8; x += 8) {
+            __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + x), _mm256_loadu_ps(b + x));
+            d = _mm256_mul_ps(d, d);
+            sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm256_castps256_ps128(d)));
+            sum = _mm256_add_pd(sum, _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1)));
+        }
+        alignas(32) double s[4];
+        _mm256_store_pd(s, sum);
+        return (s[0] + s[1]) + (s[2] + s[3]) + sse_row_c(a, b, w8, width);
+    } else if constexpr (sizeof(T) == 1) {
+        // 32bit lanes are enough for rows of up to 512k samples.
+        const int w32 = width & ~31;
+        __m256i sum = zero;
+        for (int x = 0; x < w32; x += 32) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x));
+            __m256i d = _mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+            __m256i lo = _mm256_unpacklo_epi8(d, zero);
+            __m256i hi = _mm256_unpackhi_epi8(d, zero);
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(lo, lo));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(hi, hi));
+        }
+        alignas(32) uint32_t s[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s), sum);
+        uint64_t total = 0;
+        for (int i = 0; i < 8; ++i) {
+            total += s[i];
+        }
+        return static_cast<double>(total) + sse_row_c(a, b, w32, width);
+    } else {
+        const int w16 = width & ~15;
+        __m256i sum = zero;
+        for (int x = 0; x < w16; x += 16) {
+            __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x));
+            __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x));
+            __m256i d = _mm256_or_si256(_mm256_subs_epu16(va, vb), _mm256_subs_epu16(vb, va));
+            __m256i lo = _mm256_mullo_epi16(d, d);
+            __m256i hi = _mm256_mulhi_epu16(d, d);
+            __m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+            __m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+            sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(p0, zero));
+            sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(p0, zero));
+            sum = _mm256_add_epi64(sum, _mm256_unpacklo_epi32(p1, zero));
+            sum = _mm256_add_epi64(sum, _mm256_unpackhi_epi32(p1, zero));
+        }
+        alignas(32) uint64_t s[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(s), sum);
+        return static_cast<double>(s[0] + s[1] + s[2] + s[3])
+             + sse_row_c(a, b, w16, width);
+    }
+}
+
+template double sse_row_avx2<uint8_t>(const uint8_t*, const uint8_t*, int);
+template double sse_row_avx2<uint16_t>(const uint16_t*, const uint16_t*, int);
+template double sse_row_avx2<float>(const float*, const float*, int);
+
+
+template <typename T>
+static inline __m256d load4_pd(const T* p)
+{
+    if constexpr (std::is_floating_point_v<T>) {
+        return _mm256_cvtps_pd(_mm_loadu_ps(p));
+    } else if constexpr (sizeof(T) == 1) {
+        __m128i x = _mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(p));
+        return _mm256_cvtepi32_pd(_mm_cvtepu8_epi32(x));
+    } else {
+        __m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(x));
+    }
+}
+
+
+// a block is one vector of its 4 columns.
+template <typename T>
+void ssim_4x4_row_avx2(const T* a, int apitch, const T* b, int bpitch,
+                       double* sums, int blocks)
+{
+    for (int i = 0; i < blocks; ++i) {
+        __m256d s1 = _mm256_setzero_pd();
+        __m256d s2 = _mm256_setzero_pd();
+        __m256d ss = _mm256_setzero_pd();
+        __m256d s12 = _mm256_setzero_pd();
+        for (int y = 0; y < 4; ++y) {
+            __m256d va = load4_pd(a + y * apitch + 4 * i);
+            __m256d vb = load4_pd(b + y * bpitch + 4 * i);
+            s1 = _mm256_add_pd(s1, va);
+            s2 = _mm256_add_pd(s2, vb);
+            // no FMA, results have to match the SSE2 and C versions.
+            ss = _mm256_add_pd(ss, _mm256_add_pd(_mm256_mul_pd(va, va),
+                                                 _mm256_mul_pd(vb, vb)));
+            s12 = _mm256_add_pd(s12, _mm256_mul_pd(va, vb));
+        }
+        // (0 + 1) + (2 + 3) of s1, s2, ss and s12.
+        __m256d t0 = _mm256_hadd_pd(s1, s2);
+        __m256d t1 = _mm256_hadd_pd(ss, s12);
+        __m256d r = _mm256_add_pd(_mm256_permute2f128_pd(t0, t1, 0x20),
+                                  _mm256_permute2f128_pd(t0, t1, 0x31));
+        _mm256_storeu_pd(sums + 4 * i, r);
+    }
+}
+
+template void ssim_4x4_row_avx2<uint8_t>(
+    const uint8_t*, int, const uint8_t*, int, double*, int);
+template void ssim_4x4_row_avx2<uint16_t>(
+    const uint16_t*, int, const uint16_t*, int, double*, int);
+template void ssim_4x4_row_avx2<float>(
+    const float*, int, const float*, int, double*, int);
+
+
+template <typename T>
+void stats_row_avx2(const T* p, int width, row_stats_t& s)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    if constexpr (std::is_floating_point_v<T>) {
+        const int w8 = width & ~7;
+        if (w8 > 0) {
+            __m256 mn = _mm256_loadu_ps(p);
+            __m256 mx = mn;
+            __m256d sum = _mm256_setzero_pd();
+            __m256d sq = _mm256_setzero_pd();
+            for (int x = 0; x < w8; x += 8) {
+                __m256 v = _mm256_loadu_ps(p + x);
+                mn = _mm256_min_ps(mn, v);
+                mx = _mm256_max_ps(mx, v);
+                __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+                __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+                sum = _mm256_add_pd(sum, _mm256_add_pd(lo, hi));
+                sq = _mm256_add_pd(sq, _mm256_add_pd(_mm256_mul_pd(lo, lo),
+                                                     _mm256_mul_pd(hi, hi)));
+            }
+            alignas(32) float fmin[8], fmax[8];
+            alignas(32) double dsum[4], dsq[4];
+            _mm256_store_ps(fmin, mn);
+            _mm256_store_ps(fmax, mx);
+            _mm256_store_pd(dsum, sum);
+            _mm256_store_pd(dsq, sq);
+            for (int i = 0; i < 8; ++i) {
+                s.min = std::min(s.min, static_cast<double>(fmin[i]));
+                s.max = std::max(s.max, static_cast<double>(fmax[i]));
+            }
+            s.sum += (dsum[0] + dsum[1]) + (dsum[2] + dsum[3]);
+            s.sumsq += (dsq[0] + dsq[1]) + (dsq[2] + dsq[3]);
+        }
+        stats_row_c(p, w8, width, s);
+    } else if constexpr (sizeof(T) == 1) {
+        const int w32 = width & ~31;
+        if (w32 > 0) {
+            __m256i mn = _mm256_set1_epi8(-1);
+            __m256i mx = zero;
+            __m256i sum = zero;
+            __m256i sq = zero;
+            for (int x = 0; x < w32; x += 32) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + x));
+                mn = _mm256_min_epu8(mn, v);
+                mx = _mm256_max_epu8(mx, v);
+                sum = _mm256_add_epi64(sum, _mm256_sad_epu8(v, zero));
+                __m256i lo = _mm256_unpacklo_epi8(v, zero);
+                __m256i hi = _mm256_unpackhi_epi8(v, zero);
+                sq = _mm256_add_epi32(sq, _mm256_madd_epi16(lo, lo));
+                sq = _mm256_add_epi32(sq, _mm256_madd_epi16(hi, hi));
+            }
+            alignas(32) uint8_t bmin[32], bmax[32];
+            alignas(32) uint64_t qsum[4];
+            alignas(32) uint32_t dsq[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(bmin), mn);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(bmax), mx);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(qsum), sum);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(dsq), sq);
+            uint64_t total = 0;
+            for (int i = 0; i < 8; ++i) {
+                total += dsq[i];
+            }
+            s.min = std::min(s.min, static_cast<double>(*std::min_element(bmin, bmin + 32)));
+            s.max = std::max(s.max, static_cast<double>(*std::max_element(bmax, bmax + 32)));
+            s.sum += static_cast<double>(qsum[0] + qsum[1] + qsum[2] + qsum[3]);
+            s.sumsq += static_cast<double>(total);
+        }
+        stats_row_c(p, w32, width, s);
+    } else {
+        const int w16 = width & ~15;
+        if (w16 > 0) {
+            __m256i mn = _mm256_set1_epi16(-1);
+            __m256i mx = zero;
+            __m256i sum = zero;
+            __m256i sq = zero;
+            for (int x = 0; x < w16; x += 16) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + x));
+                mn = _mm256_min_epu16(mn, v);
+                mx = _mm256_max_epu16(mx, v);
+                sum = _mm256_add_epi32(sum, _mm256_unpacklo_epi16(v, zero));
+                sum = _mm256_add_epi32(sum, _mm256_unpackhi_epi16(v, zero));
+                __m256i lo = _mm256_mullo_epi16(v, v);
+                __m256i hi = _mm256_mulhi_epu16(v, v);
+                __m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+                __m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+                sq = _mm256_add_epi64(sq, _mm256_unpacklo_epi32(p0, zero));
+                sq = _mm256_add_epi64(sq, _mm256_unpackhi_epi32(p0, zero));
+                sq = _mm256_add_epi64(sq, _mm256_unpacklo_epi32(p1, zero));
+                sq = _mm256_add_epi64(sq, _mm256_unpackhi_epi32(p1, zero));
+            }
+            alignas(32) uint16_t wmin[16], wmax[16];
+            alignas(32) uint32_t dsum[8];
+            alignas(32) uint64_t qsq[4];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(wmin), mn);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(wmax), mx);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(dsum), sum);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(qsq), sq);
+            uint64_t total = 0;
+            for (int i = 0; i < 8; ++i) {
+                total += dsum[i];
+            }
+            s.min = std::min(s.min, static_cast<double>(*std::min_element(wmin, wmin + 16)));
+            s.max = std::max(s.max, static_cast<double>(*std::max_element(wmax, wmax + 16)));
+            s.sum += static_cast<double>(total);
+            s.sumsq += static_cast<double>(qsq[0] + qsq[1] + qsq[2] + qsq[3]);
+        }
+        stats_row_c(p, w16, width, s);
+    }
+}
+
+template void stats_row_avx2<uint8_t>(const uint8_t*, int, row_stats_t&);
+template void stats_row_avx2<uint16_t>(const uint16_t*, int, row_stats_t&);
+template void stats_row_avx2<float>(const float*, int, row_stats_t&);
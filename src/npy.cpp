@@ -0,0 +1,45 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <format>
+#include "npy.h"
+
+
+std::string npy_header(const char* descr, const std::vector<int64_t>& shape)
+{
+    std::string dict = std::format("{{'descr': '{}', 'fortran_order': False, 'shape': (",
+                                   descr);
+    for (size_t i = 0; i < shape.size(); ++i) {
+        dict += std::format("{}{}", i > 0 ? ", " : "", shape[i]);
+    }
+    dict += shape.size() == 1 ? ",), }" : "), }";
+
+    // magic(6) + version(2) + header_len(2) + dict + '\n'
+    const size_t total = (10 + dict.size() + 1 + 63) / 64 * 64;
+    dict.append(total - 10 - dict.size() - 1, ' ');
+    dict += '\n';
+
+    std::string header("\x93NUMPY\x01\x00", 8);
+    header += static_cast<char>(dict.size() & 0xFF);
+    header += static_cast<char>(dict.size() >> 8);
+    return header + dict;
+}
@@ -0,0 +1,39 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+// NPY format version 1.0
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+
+#ifndef A2PM_NPY_H
+#define A2PM_NPY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// the header of a C order array of shape with elements of descr ("|u1",
+// "<u2", "<f4", ...). it is padded so that the data starts at a multiple of
+// 64 bytes, which lets np.memmap/np.load map the data as it is.
+std::string npy_header(const char* descr, const std::vector<int64_t>& shape);
+
+#endif
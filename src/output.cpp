@@ -0,0 +1,706 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <stdexcept>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/ioctl.h>
+#endif
+#include "output.h"
+
+
+StdioOutput::StdioOutput(FILE* f, size_t max_frame_size) : fp(f)
+{
+    if (max_frame_size > 0) {
+        buff = std::make_unique<Buffer>(max_frame_size, 64);
+    }
+}
+
+
+bool StdioOutput::write(const void* data, size_t size)
+{
+    return fwrite(data, 1, size, fp) == size;
+}
+
+
+bool StdioOutput::
+writeFrame(const char* header, const plane_t* planes, int num, const PVideoFrame&)
+{
+    if (header && fputs(header, fp) == EOF) {
+        return false;
+    }
+    uint8_t* dst = reinterpret_cast<uint8_t*>(buff->data());
+    for (int p = 0; p < num; ++p) {
+        const plane_t& pl = planes[p];
+        size_t count = static_cast<size_t>(pl.rowsize) * pl.height;
+        if (pl.rowsize == pl.pitch) {
+            if (!write(pl.ptr, count)) {
+                return false;
+            }
+            continue;
+        }
+        const uint8_t* srcp = pl.ptr;
+        uint8_t* dstp = dst;
+        for (int y = 0; y < pl.height; ++y) {
+            memcpy(dstp, srcp, pl.rowsize);
+            dstp += pl.rowsize;
+            srcp += pl.pitch;
+        }
+        if (!write(dst, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+bool StdioOutput::flush()
+{
+    return fflush(fp) == 0 && !ferror(fp);
+}
+
+
+#if !defined(_WIN32)
+
+WritevOutput::WritevOutput(int f) : fd(f), written(0) {}
+
+
+// advances vec/count past 'done' bytes that have been sent.
+static inline void consume_iov(iovec*& vec, int& count, size_t done)
+{
+    while (count > 0 && done >= vec->iov_len) {
+        done -= vec->iov_len;
+        ++vec;
+        --count;
+    }
+    if (count > 0) {
+        vec->iov_base = reinterpret_cast<uint8_t*>(vec->iov_base) + done;
+        vec->iov_len -= done;
+    }
+}
+
+
+bool WritevOutput::writevAll(iovec* vec, int count)
+{
+    while (count > 0) {
+        ssize_t ret = writev(fd, vec, count);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += ret;
+        consume_iov(vec, count, static_cast<size_t>(ret));
+    }
+    return true;
+}
+
+
+bool WritevOutput::write(const void* data, size_t size)
+{
+    iovec vec = { const_cast<void*>(data), size };
+    return writevAll(&vec, 1);
+}
+
+
+void WritevOutput::buildIov(const char* header, const plane_t* planes, int num)
+{
+    iov.clear();
+    if (header) {
+        iov.push_back({ const_cast<char*>(header), strlen(header) });
+    }
+    for (int p = 0; p < num; ++p) {
+        const plane_t& pl = planes[p];
+        if (pl.rowsize == pl.pitch) {
+            size_t count = static_cast<size_t>(pl.rowsize) * pl.height;
+            iov.push_back({ const_cast<uint8_t*>(pl.ptr), count });
+            continue;
+        }
+        const uint8_t* srcp = pl.ptr;
+        for (int y = 0; y < pl.height; ++y) {
+            iov.push_back({ const_cast<uint8_t*>(srcp), static_cast<size_t>(pl.rowsize) });
+            srcp += pl.pitch;
+        }
+    }
+}
+
+
+bool WritevOutput::
+writeFrame(const char* header, const plane_t* planes, int num, const PVideoFrame&)
+{
+    buildIov(header, planes, num);
+    for (size_t i = 0; i < iov.size(); i += IOV_MAX) {
+        int count = static_cast<int>(std::min<size_t>(IOV_MAX, iov.size() - i));
+        if (!writevAll(iov.data() + i, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif
+
+
+#if defined(__linux__)
+
+SpliceOutput::SpliceOutput(int f) : WritevOutput(f)
+{
+    // a larger pipe lets more frames be in flight without blocking.
+    int size = 0;
+    FILE* fp = fopen("/proc/sys/fs/pipe-max-size", "r");
+    if (fp) {
+        if (fscanf(fp, "%d", &size) != 1) {
+            size = 0;
+        }
+        fclose(fp);
+    }
+    if (size > 0) {
+        fcntl(fd, F_SETPIPE_SZ, size);
+    }
+    a2pm_log(LOG_INFO, "stdout is a pipe, using vmsplice with %d bytes pipe buffer.\n",
+             fcntl(fd, F_GETPIPE_SZ));
+}
+
+
+SpliceOutput::~SpliceOutput()
+{
+    flush();
+}
+
+
+bool SpliceOutput::spliceAll(iovec* vec, int count)
+{
+    while (count > 0) {
+        ssize_t ret = vmsplice(fd, vec, count, 0);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += ret;
+        consume_iov(vec, count, static_cast<size_t>(ret));
+        release();
+    }
+    return true;
+}
+
+
+// drops the frames whose bytes have all been read from the pipe.
+void SpliceOutput::release()
+{
+    int inpipe = 0;
+    if (ioctl(fd, FIONREAD, &inpipe) < 0) {
+        return;
+    }
+    uint64_t consumed = written - inpipe;
+    while (!pending.empty() && pending.front().end <= consumed) {
+        pending.pop_front();
+    }
+}
+
+
+bool SpliceOutput::
+writeFrame(const char* header, const plane_t* planes, int num, const PVideoFrame& owner)
+{
+    if (!owner) {
+        return WritevOutput::writeFrame(header, planes, num, owner);
+    }
+
+    buildIov(header, planes, num);
+    for (size_t i = 0; i < iov.size(); i += IOV_MAX) {
+        int count = static_cast<int>(std::min<size_t>(IOV_MAX, iov.size() - i));
+        if (!spliceAll(iov.data() + i, count)) {
+            return false;
+        }
+    }
+    pending.push_back({ owner, written });
+    return true;
+}
+
+
+// a pipe has no event for becoming empty. this blocks in poll() until the
+// reader goes away, waking up after a timeout that grows up to 64 msec to
+// see how much it has read.
+bool SpliceOutput::flush()
+{
+    int timeout = 1;
+    while (true) {
+        release();
+        if (pending.empty()) {
+            return true;
+        }
+        // reader has gone away, nobody will consume the rest.
+        pollfd pfd = { fd, 0, 0 };
+        if (poll(&pfd, 1, timeout) > 0 && (pfd.revents & (POLLERR | POLLHUP))) {
+            pending.clear();
+            return false;
+        }
+        timeout = std::min(timeout * 2, 64);
+    }
+}
+
+#endif
+
+
+static constexpr size_t DIRECT_ALIGN = 4096;
+static constexpr size_t DIRECT_BUFF_SIZE = 8 * 1024 * 1024;
+static constexpr int DIRECT_NUM_BUFFS = 4;
+
+
+static inline int64_t now_usec()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(
+        steady_clock::now().time_since_epoch()).count();
+}
+
+
+#if defined(_WIN32)
+
+static file_handle_t open_direct(const char* path, bool keep)
+{
+    HANDLE h = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                           nullptr, keep ? OPEN_ALWAYS : CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING,
+                           nullptr);
+    validate(h == INVALID_HANDLE_VALUE,
+             std::format("failed to open {}.\n", path));
+    return h;
+}
+
+static size_t read_at(file_handle_t h, void* data, size_t size, uint64_t offset)
+{
+    OVERLAPPED ov = {};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD done = 0;
+    if (!ReadFile(h, data, static_cast<DWORD>(size), &done, &ov)) {
+        return 0;
+    }
+    return done;
+}
+
+static uint64_t get_file_size(file_handle_t h)
+{
+    LARGE_INTEGER size;
+    return GetFileSizeEx(h, &size) ? size.QuadPart : 0;
+}
+
+static bool write_at(file_handle_t h, const void* data, size_t size, uint64_t offset)
+{
+    OVERLAPPED ov = {};
+    ov.Offset = static_cast<DWORD>(offset);
+    ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD done = 0;
+    return WriteFile(h, data, static_cast<DWORD>(size), &done, &ov)
+        && done == size;
+}
+
+static void preallocate(file_handle_t h, uint64_t size)
+{
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = size;
+    SetFileInformationByHandle(h, FileAllocationInfo, &info, sizeof(info));
+}
+
+static bool truncate_at(file_handle_t h, uint64_t size)
+{
+    FILE_END_OF_FILE_INFO info;
+    info.EndOfFile.QuadPart = size;
+    return SetFileInformationByHandle(h, FileEndOfFileInfo, &info, sizeof(info));
+}
+
+static bool sync_file(file_handle_t h)
+{
+    return FlushFileBuffers(h) != 0;
+}
+
+static void close_file(file_handle_t h)
+{
+    CloseHandle(h);
+}
+
+#else
+
+static file_handle_t open_direct(const char* path, bool keep)
+{
+    int flags = O_RDWR | O_CREAT | (keep ? 0 : O_TRUNC);
+#if defined(O_DIRECT)
+    int fd = open(path, flags | O_DIRECT, 0644);
+    if (fd >= 0) {
+        return fd;
+    }
+    // some filesystems (e.g. tmpfs) do not support O_DIRECT.
+    a2pm_log(LOG_WARNING, "O_DIRECT is not available for %s.\n", path);
+#endif
+    int fd2 = open(path, flags, 0644);
+    validate(fd2 < 0, std::format("failed to open {}.\n", path));
+#if defined(F_NOCACHE)
+    fcntl(fd2, F_NOCACHE, 1);
+#endif
+    return fd2;
+}
+
+static size_t read_at(file_handle_t fd, void* data, size_t size, uint64_t offset)
+{
+    ssize_t ret;
+    do {
+        ret = pread(fd, data, size, offset);
+    } while (ret < 0 && errno == EINTR);
+    return ret < 0 ? 0 : ret;
+}
+
+static uint64_t get_file_size(file_handle_t fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 ? st.st_size : 0;
+}
+
+static bool write_at(file_handle_t fd, const void* data, size_t size, uint64_t offset)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t ret = pwrite(fd, p, size, offset);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += ret;
+        size -= ret;
+        offset += ret;
+    }
+    return true;
+}
+
+static void preallocate(file_handle_t fd, uint64_t size)
+{
+#if defined(__linux__)
+    posix_fallocate(fd, 0, size);
+#endif
+}
+
+static bool truncate_at(file_handle_t fd, uint64_t size)
+{
+    return ftruncate(fd, size) == 0;
+}
+
+static bool sync_file(file_handle_t fd)
+{
+    return fsync(fd) == 0;
+}
+
+static void close_file(file_handle_t fd)
+{
+    close(fd);
+}
+
+#endif
+
+
+DirectFileOutput::
+DirectFileOutput(const char* p, uint64_t expected_size, uint64_t resume_at) :
+    path(p), busy(0), failed(false), stop(false), fill(0), offset(0),
+    kept(resume_at)
+{
+    file = open_direct(path, resume_at > 0);
+    for (int i = 0; i < DIRECT_NUM_BUFFS; ++i) {
+        buffs.push_back(std::make_unique<Buffer>(DIRECT_BUFF_SIZE, DIRECT_ALIGN));
+        idle.push_back(i);
+    }
+    cur = idle.front();
+    idle.pop_front();
+
+    if (resume_at > 0) {
+        // anything after resume_at is an incomplete frame of the last run.
+        // the partial sector before it is read back into the buffer, so
+        // that writes stay sector aligned.
+        bool ok = get_file_size(file) >= resume_at && truncate_at(file, resume_at);
+        offset = resume_at & ~static_cast<uint64_t>(DIRECT_ALIGN - 1);
+        fill = static_cast<size_t>(resume_at - offset);
+        if (ok && fill > 0) {
+            ok = read_at(file, buffs[cur]->data(), DIRECT_ALIGN, offset) >= fill;
+        }
+        if (!ok) {
+            close_file(file);
+            throw std::runtime_error(
+                std::format("cannot resume {} at {} bytes.\n", path, resume_at));
+        }
+    }
+    if (expected_size > resume_at) {
+        preallocate(file, expected_size);
+    }
+    start = now_usec();
+    io = std::thread(&DirectFileOutput::run, this);
+}
+
+
+DirectFileOutput::~DirectFileOutput()
+{
+    flush();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+    io.join();
+    close_file(file);
+
+    double sec = (now_usec() - start) / 1000000.0;
+    double mb = (offset + fill - kept) / 1048576.0;
+    a2pm_log(LOG_INFO, "wrote %.1f MB to %s in %.3f sec [%.1f MB/s].\n",
+             mb, path, sec, sec > 0 ? mb / sec : 0.0);
+}
+
+
+void DirectFileOutput::run()
+{
+    while (true) {
+        job_t job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stop || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            job = jobs.front();
+            jobs.pop_front();
+            ++busy;
+        }
+        bool ok = write_at(file, buffs[job.index]->data(), job.size, job.offset);
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            --busy;
+            if (!ok) {
+                failed = true;
+            }
+            idle.push_back(job.index);
+        }
+        cv.notify_all();
+    }
+}
+
+
+// queues the current buffer and switches to an idle one.
+void DirectFileOutput::submit(size_t size)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    jobs.push_back({ cur, size, offset });
+    cv.notify_all();
+    cv.wait(lock, [this] { return !idle.empty(); });
+    cur = idle.front();
+    idle.pop_front();
+}
+
+
+void DirectFileOutput::wait()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this] { return jobs.empty() && busy == 0; });
+}
+
+
+// returns the free part of the current buffer, submitting it if it is full.
+uint8_t* DirectFileOutput::reserve(size_t& size)
+{
+    if (fill == DIRECT_BUFF_SIZE) {
+        submit(DIRECT_BUFF_SIZE);
+        offset += DIRECT_BUFF_SIZE;
+        fill = 0;
+    }
+    size = std::min(size, DIRECT_BUFF_SIZE - fill);
+    return reinterpret_cast<uint8_t*>(buffs[cur]->data()) + fill;
+}
+
+
+bool DirectFileOutput::write(const void* data, size_t size)
+{
+    const uint8_t* srcp = reinterpret_cast<const uint8_t*>(data);
+    while (size > 0) {
+        size_t len = size;
+        uint8_t* dstp = reserve(len);
+        memcpy(dstp, srcp, len);
+        fill += len;
+        srcp += len;
+        size -= len;
+    }
+    return !failed;
+}
+
+
+bool DirectFileOutput::
+writeFrame(const char* header, const plane_t* planes, int num, const PVideoFrame&)
+{
+    if (header) {
+        write(header, strlen(header));
+    }
+    for (int p = 0; p < num; ++p) {
+        const plane_t& pl = planes[p];
+        if (pl.rowsize == pl.pitch) {
+            write(pl.ptr, static_cast<size_t>(pl.rowsize) * pl.height);
+            continue;
+        }
+        const uint8_t* srcp = pl.ptr;
+        for (int y = 0; y < pl.height; ++y) {
+            write(srcp, pl.rowsize);
+            srcp += pl.pitch;
+        }
+    }
+    return !failed;
+}
+
+
+// writes the partial tail padded to the sector size, and waits for all the
+// buffers. the tail stays in the current buffer, so writing can go on
+// afterwards.
+void DirectFileOutput::writeTail()
+{
+    if (fill > 0) {
+        size_t size = (fill + DIRECT_ALIGN - 1) & ~(DIRECT_ALIGN - 1);
+        uint8_t* data = reinterpret_cast<uint8_t*>(buffs[cur]->data());
+        memset(data + fill, 0, size - fill);
+        std::unique_lock<std::mutex> lock(mtx);
+        jobs.push_back({ cur, size, offset });
+        cv.notify_all();
+    }
+    wait();
+    if (fill > 0) {
+        std::lock_guard<std::mutex> lock(mtx);
+        // the tail buffer came back to the idle list, take it again.
+        idle.erase(std::find(idle.begin(), idle.end(), cur));
+    }
+}
+
+
+// cuts the padding and the preallocated space off the end of the file.
+bool DirectFileOutput::flush()
+{
+    writeTail();
+    if (!truncate_at(file, offset + fill)) {
+        failed = true;
+    }
+    return !failed;
+}
+
+
+// the file keeps the preallocated size, which later writes fill, and a
+// resumed run cuts the rest off.
+bool DirectFileOutput::sync()
+{
+    writeTail();
+    if (!sync_file(file)) {
+        failed = true;
+    }
+    return !failed;
+}
+
+
+HashOutput::HashOutput(std::unique_ptr<Output> o, const XXH64& h, uint64_t b) :
+    out(std::move(o)), hash(h), bytes(b) {}
+
+
+bool HashOutput::write(const void* data, size_t size)
+{
+    hash.update(data, size);
+    bytes += size;
+    return out->write(data, size);
+}
+
+
+bool HashOutput::
+writeFrame(const char* header, const plane_t* planes, int num,
+           const PVideoFrame& owner)
+{
+    if (header) {
+        size_t len = strlen(header);
+        hash.update(header, len);
+        bytes += len;
+    }
+    for (int p = 0; p < num; ++p) {
+        const plane_t& pl = planes[p];
+        const uint8_t* srcp = pl.ptr;
+        for (int y = 0; y < pl.height; ++y) {
+            hash.update(srcp, pl.rowsize);
+            srcp += pl.pitch;
+        }
+        bytes += static_cast<uint64_t>(pl.rowsize) * pl.height;
+    }
+    return out->writeFrame(header, planes, num, owner);
+}
+
+
+bool HashOutput::flush()
+{
+    return out->flush();
+}
+
+
+bool HashOutput::sync()
+{
+    return out->sync();
+}
+
+
+std::unique_ptr<Output>
+create_output(output_type_t type, const char* path, size_t max_frame_size,
+              uint64_t expected_size, uint64_t resume_at)
+{
+    if (path) {
+        return std::make_unique<DirectFileOutput>(path, expected_size, resume_at);
+    }
+
+    FILE* fp = stdout;
+    if (type == OUT_VMSPLICE) {
+#if defined(__linux__)
+        struct stat st;
+        if (fstat(fileno(fp), &st) == 0 && S_ISFIFO(st.st_mode)) {
+            fflush(fp);
+            return std::make_unique<SpliceOutput>(fileno(fp));
+        }
+        a2pm_log(LOG_WARNING, "stdout is not a pipe, -vmsplice is ignored.\n");
+#else
+        throw std::runtime_error("vmsplice output is not supported on this platform.\n");
+#endif
+    }
+    if (type == OUT_WRITEV) {
+#if defined(_WIN32)
+        throw std::runtime_error("writev output is not supported on this platform.\n");
+#else
+        fflush(fp);
+        return std::make_unique<WritevOutput>(fileno(fp));
+#endif
+    }
+    return std::make_unique<StdioOutput>(fp, max_frame_size);
+}
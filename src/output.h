@@ -0,0 +1,205 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#ifndef A2PM_OUTPUT_H
+#define A2PM_OUTPUT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#endif
+#include "avs2pipemod.h"
+#include "hash.h"
+#include "utils.h"
+
+
+// rows of one plane to be written.
+struct plane_t {
+    const uint8_t* ptr;
+    int rowsize;
+    int pitch;
+    int height;
+};
+
+
+class Output {
+public:
+    virtual ~Output() {}
+    virtual bool write(const void* data, size_t size) = 0;
+    // header is nullptr or a string literal such as "FRAME\n".
+    // owner is the frame that planes point into, or an empty frame if they
+    // point to a temporary buffer that is only valid during the call.
+    virtual bool writeFrame(const char* header, const plane_t* planes, int num,
+                            const PVideoFrame& owner) = 0;
+    // writes out what is buffered, and waits for writes that are still in
+    // progress. returns false if any write so far has failed.
+    virtual bool flush() { return true; }
+    // flush() for checkpoints. the data is on the disk when it returns
+    // true, and a preallocated file keeps its size.
+    virtual bool sync() { return flush(); }
+};
+
+
+// fwrite to stdout. padded planes are packed into a staging buffer first.
+class StdioOutput : public Output {
+    FILE* fp;
+    std::unique_ptr<Buffer> buff;
+public:
+    StdioOutput(FILE* fp, size_t max_frame_size);
+    bool write(const void* data, size_t size) override;
+    bool writeFrame(const char* header, const plane_t* planes, int num,
+                    const PVideoFrame& owner) override;
+    bool flush() override;
+};
+
+
+#if !defined(_WIN32)
+// writev to a file descriptor. every row is sent straight from frame memory,
+// so that a frame costs one syscall per IOV_MAX rows and no copy.
+class WritevOutput : public Output {
+protected:
+    int fd;
+    uint64_t written;
+    std::vector<iovec> iov;
+    void buildIov(const char* header, const plane_t* planes, int num);
+    bool writevAll(iovec* vec, int count);
+public:
+    WritevOutput(int fd);
+    bool write(const void* data, size_t size) override;
+    bool writeFrame(const char* header, const plane_t* planes, int num,
+                    const PVideoFrame& owner) override;
+};
+#endif
+
+
+#if defined(__linux__)
+// vmsplice frame memory into a pipe, so that the kernel does not copy it
+// either. the pipe keeps referencing the pages until the reader consumes
+// them, so every frame is held until its last byte has left the pipe.
+// that is only safe if the reader copies the data out with read(). a reader
+// that splice()s or tee()s it onward still references the pages after the
+// frame is released and AviSynth reuses it, so this is never the default.
+class SpliceOutput : public WritevOutput {
+    struct pending_t {
+        PVideoFrame frame;
+        uint64_t end;
+    };
+    std::deque<pending_t> pending;
+    bool spliceAll(iovec* vec, int count);
+    void release();
+public:
+    SpliceOutput(int fd);
+    ~SpliceOutput();
+    bool writeFrame(const char* header, const plane_t* planes, int num,
+                    const PVideoFrame& owner) override;
+    bool flush() override;
+};
+#endif
+
+
+#if defined(_WIN32)
+typedef HANDLE file_handle_t;
+#else
+typedef int file_handle_t;
+#endif
+
+
+// unbuffered file writer. data is gathered into several sector aligned
+// buffers which are written by an I/O thread while the next ones are being
+// filled, bypassing the page cache (FILE_FLAG_NO_BUFFERING / O_DIRECT).
+// if resume_at is not 0, the first resume_at bytes of the existing file are
+// kept and writing continues after them.
+class DirectFileOutput : public Output {
+    struct job_t {
+        int index;
+        size_t size;
+        uint64_t offset;
+    };
+    file_handle_t file;
+    const char* path;
+    std::vector<std::unique_ptr<Buffer>> buffs;
+    std::deque<int> idle;
+    std::deque<job_t> jobs;
+    int busy;
+    std::atomic<bool> failed;
+    bool stop;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread io;
+    int cur;            // index of the buffer being filled
+    size_t fill;        // bytes in the current buffer
+    uint64_t offset;    // file offset of the current buffer
+    uint64_t kept;      // bytes of the file before resuming
+    int64_t start;
+
+    void run();
+    void submit(size_t size);
+    void wait();
+    void writeTail();
+    uint8_t* reserve(size_t& size);
+public:
+    DirectFileOutput(const char* path, uint64_t expected_size,
+                     uint64_t resume_at = 0);
+    ~DirectFileOutput();
+    bool write(const void* data, size_t size) override;
+    bool writeFrame(const char* header, const plane_t* planes, int num,
+                    const PVideoFrame& owner) override;
+    bool flush() override;
+    bool sync() override;
+};
+
+
+// passes everything to another output, counting the bytes and hashing them
+// as they appear in the stream.
+class HashOutput : public Output {
+    std::unique_ptr<Output> out;
+    XXH64 hash;
+    uint64_t bytes;
+public:
+    // hash and bytes are the state after the data that is already written.
+    HashOutput(std::unique_ptr<Output> out, const XXH64& hash = XXH64(),
+               uint64_t bytes = 0);
+    bool write(const void* data, size_t size) override;
+    bool writeFrame(const char* header, const plane_t* planes, int num,
+                    const PVideoFrame& owner) override;
+    bool flush() override;
+    bool sync() override;
+    uint64_t size() const { return bytes; }
+    uint64_t digest() const { return hash.digest(); }
+    const XXH64& state() const { return hash; }
+};
+
+
+// path is nullptr for stdout. expected_size is used for preallocation.
+// resume_at is passed to DirectFileOutput.
+std::unique_ptr<Output>
+create_output(output_type_t type, const char* path, size_t max_frame_size,
+              uint64_t expected_size, uint64_t resume_at = 0);
+
+#endif
@@ -0,0 +1,116 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#include <algorithm>
+#include <stdexcept>
+#include "prefetcher.h"
+
+
+FramePrefetcher::
+FramePrefetcher(fetch_t f, int num_frames, int threads, int d, int c, int first) :
+    fetch(f), numFrames(num_frames), depth(d), chunk(c), next(first), current(first),
+    stop(false), slots(d), ready(d, 0)
+{
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back(&FramePrefetcher::run, this, i);
+    }
+}
+
+
+FramePrefetcher::~FramePrefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    freed.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+
+void FramePrefetcher::run(int worker)
+{
+    while (true) {
+        int first, last;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            freed.wait(lock, [this] {
+                return stop || next >= numFrames || next + chunk <= current + depth;
+            });
+            if (stop || next >= numFrames) {
+                return;
+            }
+            first = next;
+            last = std::min(next + chunk, numFrames);
+            next = last;
+        }
+
+        for (int n = first; n < last; ++n) {
+            PVideoFrame frame;
+            std::string msg;
+            try {
+                frame = fetch(n, worker);
+            } catch (AvisynthError& e) {
+                msg = e.msg;
+            } catch (std::exception& e) {
+                msg = e.what();
+            }
+
+            std::lock_guard<std::mutex> lock(mtx);
+            if (!msg.empty()) {
+                if (error.empty()) {
+                    error = msg;
+                }
+                stop = true;
+            } else {
+                slots[n % depth] = frame;
+                ready[n % depth] = 1;
+            }
+            filled.notify_all();
+            freed.notify_all();
+            if (stop) {
+                return;
+            }
+        }
+    }
+}
+
+
+PVideoFrame FramePrefetcher::get(int n)
+{
+    const int slot = n % depth;
+    PVideoFrame frame;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        current = n;
+        freed.notify_all();
+        filled.wait(lock, [&] { return ready[slot] || !error.empty(); });
+        if (!ready[slot]) {
+            throw std::runtime_error(error);
+        }
+        frame = slots[slot];
+        slots[slot] = nullptr;
+        ready[slot] = 0;
+    }
+    return frame;
+}
@@ -0,0 +1,68 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+#ifndef A2PM_PREFETCHER_H
+#define A2PM_PREFETCHER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "avs2pipemod.h"
+
+
+// worker pool that requests frames ahead of the consumer and hands them
+// back strictly in order. at most 'depth' frames are alive at once,
+// counting requested, ready and the one the consumer is working on.
+// each worker takes 'chunk' consecutive frames at a time and requests them
+// in order. the consumer starts at frame 'first'.
+class FramePrefetcher {
+public:
+    typedef std::function<PVideoFrame(int n, int worker)> fetch_t;
+
+private:
+    fetch_t fetch;
+    int numFrames;
+    int depth;
+    int chunk;
+    int next;       // next frame number to be requested
+    int current;    // frame number the consumer is waiting for or holding
+    bool stop;
+    std::string error;
+    std::vector<PVideoFrame> slots;
+    std::vector<char> ready;
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable filled;
+    std::condition_variable freed;
+
+    void run(int worker);
+
+public:
+    FramePrefetcher(fetch_t fetch, int num_frames, int threads, int depth,
+                    int chunk = 1, int first = 0);
+    ~FramePrefetcher();
+    PVideoFrame get(int n);
+};
+
+#endif
@@ -0,0 +1,213 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <cinttypes>
+#include <cstring>
+#include <format>
+#include "jsonwriter.h"
+#include "output.h"
+#include "propscolumns.h"
+#include "propsdump.h"
+#include "utils.h"
+
+
+static constexpr char MAGIC[] = "A2PMCOL1";
+static constexpr uint64_t ALIGN = 64;
+
+
+PropsColumns::PropsColumns(ise_t* e, const char* k) :
+    env(e), keys(split_prop_keys(k)), rows(0), mismatches(0)
+{
+}
+
+
+// ends the row of the current frame in the column.
+void PropsColumns::next(column_t& c, bool valid)
+{
+    if (c.validity.size() * 8 <= static_cast<size_t>(c.count)) {
+        c.validity.push_back(0);
+    }
+    if (valid) {
+        c.validity[c.count / 8] |= 1 << (c.count % 8);
+    } else if (c.list || c.type == 's' || c.type == 'b') {
+        c.offsets.push_back(c.offsets.back());
+    } else {
+        c.values.resize(c.values.size() + 8);
+    }
+    ++c.count;
+}
+
+
+void PropsColumns::addProp(const AVSMap* map, const char* key)
+{
+    const char t = env->propGetType(map, key);
+    if (t != 'i' && t != 'f' && t != 's') {
+        return;
+    }
+    const int num = env->propNumElements(map, key);
+    const char type = t != 's' ? t
+        : env->propGetDataTypeHint(map, key, 0, nullptr)
+            == AVSPropDataTypeHint::PROPDATATYPEHINT_BINARY ? 'b' : 's';
+
+    auto it = index.find(std::string_view(key));
+    if (it == index.end()) {
+        column_t c;
+        c.name = key;
+        c.type = type;
+        c.list = t != 's' && num != 1;
+        c.count = 0;
+        if (c.list || t == 's') {
+            c.offsets.push_back(0);
+        }
+        it = index.emplace(c.name, columns.size()).first;
+        columns.push_back(std::move(c));
+        while (columns.back().count < rows - 1) {
+            next(columns.back(), false);
+        }
+    }
+    column_t& c = columns[it->second];
+    if (c.count == rows) {
+        return;     // listed twice in -props
+    }
+    if (c.type != type || (!c.list && num != 1)) {
+        ++mismatches;
+        next(c, false);
+        return;
+    }
+
+    auto append = [&c](const void* data, size_t size) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        c.values.insert(c.values.end(), p, p + size);
+    };
+    if (type == 's' || type == 'b') {
+        append(env->propGetData(map, key, 0, nullptr),
+               env->propGetDataSize(map, key, 0, nullptr));
+    } else {
+        for (int i = 0; i < num; ++i) {
+            if (type == 'i') {
+                const int64_t v = env->propGetInt(map, key, i, nullptr);
+                append(&v, 8);
+            } else {
+                const double v = env->propGetFloat(map, key, i, nullptr);
+                append(&v, 8);
+            }
+        }
+    }
+    if (!c.offsets.empty()) {
+        c.offsets.push_back(c.list ? static_cast<int64_t>(c.values.size() / 8)
+                                   : static_cast<int64_t>(c.values.size()));
+    }
+    next(c, true);
+}
+
+
+void PropsColumns::add(const AVSMap* map)
+{
+    ++rows;
+    if (keys.empty()) {
+        const int num = env->propNumKeys(map);
+        for (int i = 0; i < num; ++i) {
+            addProp(map, env->propGetKey(map, i));
+        }
+    } else {
+        for (const auto& key : keys) {
+            addProp(map, key.c_str());
+        }
+    }
+    for (auto& c : columns) {
+        if (c.count < rows) {
+            next(c, false);
+        }
+    }
+}
+
+
+void PropsColumns::write(const char* path)
+{
+    struct buffer_t {
+        const void* data;
+        uint64_t size;
+        uint64_t offset;
+    };
+    std::vector<buffer_t> buffers;
+    uint64_t pos = ALIGN;
+    auto place = [&](const void* data, uint64_t size) {
+        buffers.push_back({ data, size, pos });
+        pos += (size + ALIGN - 1) / ALIGN * ALIGN;
+        return buffers.back();
+    };
+
+    std::string footer;
+    JsonWriter w(footer);
+    auto put = [&w](const buffer_t& b) {
+        w.beginArray();
+        w.value(static_cast<int64_t>(b.offset));
+        w.value(static_cast<int64_t>(b.size));
+        w.endArray();
+    };
+    w.beginObject();
+    w.key("rows");
+    w.value(static_cast<int64_t>(rows));
+    w.key("columns");
+    w.beginArray();
+    for (const auto& c : columns) {
+        const char* name = c.type == 'i' ? "int64" : c.type == 'f' ? "float64"
+                         : c.type == 's' ? "utf8" : "binary";
+        w.beginObject();
+        w.key("name");
+        w.value(c.name);
+        w.key("type");
+        w.value(c.list ? std::format("list<{}>", name) : std::string(name));
+        w.key("validity");
+        put(place(c.validity.data(), c.validity.size()));
+        if (!c.offsets.empty()) {
+            w.key("offsets");
+            put(place(c.offsets.data(), c.offsets.size() * 8));
+        }
+        w.key("values");
+        put(place(c.values.data(), c.values.size()));
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+
+    const uint64_t footer_size = footer.size();
+    auto out = create_output(OUT_STDIO, path, 0, pos + footer_size + 16);
+    static const uint8_t zeros[ALIGN] = {};
+    bool ok = out->write(MAGIC, 8) && out->write(zeros, ALIGN - 8);
+    for (const auto& b : buffers) {
+        const uint64_t pad = (ALIGN - b.size % ALIGN) % ALIGN;
+        ok = ok && (b.size == 0 || out->write(b.data, b.size))
+                && (pad == 0 || out->write(zeros, pad));
+    }
+    ok = ok && out->write(footer.data(), footer_size)
+            && out->write(&footer_size, 8) && out->write(MAGIC, 8);
+    ok = out->flush() && ok;
+    validate(!ok, "failed to write the columns.\n");
+
+    a2pm_log(LOG_INFO, "wrote %zu columns of %d frames (%.1f MiB).\n",
+             columns.size(), rows, (pos + footer_size + 16) / 1048576.0);
+    if (mismatches > 0) {
+        a2pm_log(LOG_WARNING, "%" PRId64 " values did not fit the type of "
+                 "their column and were written as null.\n", mismatches);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_PROPSCOLUMNS_H
+#define A2PM_PROPSCOLUMNS_H
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "avs2pipemod.h"
+
+
+// collects the frame properties of -dumpprops=columnar as one typed column
+// per key, and writes them as a file that can be memory mapped:
+//
+//   "A2PMCOL1", padded to 64 bytes
+//   the buffers of the columns, each at a multiple of 64 bytes
+//   the index, a JSON object
+//   the size of the index as uint64, and "A2PMCOL1"
+//
+// numbers are little endian. the buffers have the layout of Apache Arrow
+// arrays: a validity bitmap with a bit per frame, least significant bit
+// first, then int64/float64 values, or int64 offsets of rows + 1 entries
+// into the bytes of utf8/binary values or into the elements of lists (Arrow's
+// LargeUtf8, LargeBinary and LargeList). the index has "rows" and the
+// "columns" with "name", "type" (int64, float64, utf8, binary, list<int64> or
+// list<float64>) and the [offset, size] of "validity", "offsets" if any, and
+// "values".
+// columns are added as their keys appear, and the frames before are null.
+// values that do not fit the type of their column are null too.
+class PropsColumns {
+    struct column_t {
+        std::string name;
+        char type;                      // 'i', 'f', 's'tring or 'b'inary
+        bool list;
+        int count;                      // rows so far
+        std::vector<uint8_t> validity;
+        std::vector<int64_t> offsets;   // for strings, binary and lists
+        std::vector<uint8_t> values;
+    };
+    ise_t* env;
+    std::vector<std::string> keys;      // all the keys of each frame if empty
+    std::vector<column_t> columns;
+    std::map<std::string, size_t, std::less<>> index;
+    int rows;
+    int64_t mismatches;
+
+    void addProp(const AVSMap* map, const char* key);
+    void next(column_t& c, bool valid);
+
+public:
+    // keys is the comma separated list of -props, or nullptr.
+    PropsColumns(ise_t* env, const char* keys);
+    void add(const AVSMap* map);
+    // path is nullptr for stdout.
+    void write(const char* path);
+};
+
+#endif
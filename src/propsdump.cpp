@@ -0,0 +1,146 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <cstring>
+#include "propsdump.h"
+
+
+std::vector<std::string> split_prop_keys(const char* k)
+{
+    std::vector<std::string> keys;
+    while (k && *k) {
+        const char* comma = strchr(k, ',');
+        const size_t len = comma ? comma - k : strlen(k);
+        if (len > 0) {
+            keys.emplace_back(k, len);
+        }
+        k = comma ? comma + 1 : nullptr;
+    }
+    return keys;
+}
+
+
+PropsPrinter::
+PropsPrinter(ise_t* e, const char* path, bool nd, const char* k, int num_frames) :
+    FramePrinter(path), env(e), ndjson(nd), numFrames(num_frames),
+    keys(split_prop_keys(k))
+{
+    if (!ndjson) {
+        fputs("[\n", fp);
+    }
+}
+
+
+PropsPrinter::~PropsPrinter()
+{
+    stopThreads();
+}
+
+
+// binary data is shown as the hex of its first 16 bytes.
+void PropsPrinter::putProp(JsonWriter& w, const AVSMap* map, const char* key)
+{
+    const char t = env->propGetType(map, key);
+    if (t != 'i' && t != 'f' && t != 's') {
+        return;
+    }
+    const int num = env->propNumElements(map, key);
+    w.key(key);
+    if (num > 1) {
+        w.beginArray();
+    }
+    for (int i = 0; i < num; ++i) {
+        if (t == 'i') {
+            w.value(env->propGetInt(map, key, i, nullptr));
+            continue;
+        }
+        if (t == 'f') {
+            w.value(env->propGetFloat(map, key, i, nullptr), 7);
+            continue;
+        }
+        const char* data = env->propGetData(map, key, i, nullptr);
+        const int size = env->propGetDataSize(map, key, i, nullptr);
+        if (env->propGetDataTypeHint(map, key, i, nullptr)
+                != AVSPropDataTypeHint::PROPDATATYPEHINT_BINARY) {
+            w.value(std::string_view(data, size));
+            continue;
+        }
+        static const char hex[] = "0123456789abcdef";
+        char buf[16 * 3 + 3];
+        const int length = std::min(size, 16);
+        char* p = buf;
+        for (int j = 0; j < length; ++j) {
+            const uint8_t c = static_cast<uint8_t>(data[j]);
+            *p++ = hex[c >> 4];
+            *p++ = hex[c & 15];
+            *p++ = ' ';
+        }
+        if (length < size) {
+            memcpy(p, "...", 3);
+            p += 3;
+        }
+        w.value(std::string_view(buf, p - buf));
+    }
+    if (num > 1) {
+        w.endArray();
+    }
+}
+
+
+void PropsPrinter::format(const job_t& job, std::string& text)
+{
+    const AVSMap* map = env->getFramePropsRO(job.owner);
+    JsonWriter w(text);
+    if (!ndjson) {
+        text += '\t';
+    }
+    w.beginObject();
+    if (keys.empty()) {
+        const int num = env->propNumKeys(map);
+        for (int i = 0; i < num; ++i) {
+            putProp(w, map, env->propGetKey(map, i));
+        }
+    } else {
+        for (const auto& key : keys) {
+            putProp(w, map, key.c_str());
+        }
+    }
+    w.endObject();
+    text += !ndjson && job.frame < numFrames - 1 ? ",\n" : "\n";
+}
+
+
+void PropsPrinter::add(int n, const PVideoFrame& frame)
+{
+    FramePrinter::add(n, 0, nullptr, 0, frame);
+}
+
+
+void PropsPrinter::finish()
+{
+    FramePrinter::finish();
+    if (!ndjson) {
+        fputs("]\n", fp);
+    }
+    fflush(fp);
+}
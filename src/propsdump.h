@@ -0,0 +1,58 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_PROPSDUMP_H
+#define A2PM_PROPSDUMP_H
+
+#include <string>
+#include <vector>
+#include "frameprinter.h"
+#include "jsonwriter.h"
+
+
+// the keys of the comma separated list of -props, none if keys is nullptr.
+std::vector<std::string> split_prop_keys(const char* keys);
+
+
+// formats the frame properties of -dumpprops on a pool of threads, as a JSON
+// array of one object per frame or as NDJSON, one object per line.
+class PropsPrinter : public FramePrinter {
+    ise_t* env;
+    bool ndjson;
+    int numFrames;
+    std::vector<std::string> keys;  // all the keys of each frame if empty
+
+    void format(const job_t& job, std::string& text) override;
+    void putProp(JsonWriter& w, const AVSMap* map, const char* key);
+
+public:
+    // path is nullptr for stdout. keys is the comma separated list of
+    // -props, or nullptr.
+    PropsPrinter(ise_t* env, const char* path, bool ndjson, const char* keys,
+                 int num_frames);
+    ~PropsPrinter();
+    void add(int n, const PVideoFrame& frame);
+    // prints the rest and closes the array.
+    void finish();
+};
+
+#endif
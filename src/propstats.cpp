@@ -0,0 +1,250 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <algorithm>
+#include <format>
+#include <limits>
+#include "jsonwriter.h"
+#include "propsdump.h"
+#include "propstats.h"
+#include "utils.h"
+
+
+PropStats::PropStats(ise_t* e, const char* k, int max_distinct) :
+    env(e), keys(split_prop_keys(k)), maxDistinct(max_distinct), frames(0)
+{
+}
+
+
+void PropStats::addProp(const AVSMap* map, const char* key)
+{
+    const char t = env->propGetType(map, key);
+    if (t != 'i' && t != 'f' && t != 's') {
+        return;
+    }
+    const int num = env->propNumElements(map, key);
+    const char type = t != 's' ? t
+        : env->propGetDataTypeHint(map, key, 0, nullptr)
+            == AVSPropDataTypeHint::PROPDATATYPEHINT_BINARY ? 'b' : 's';
+
+    auto it = index.find(std::string_view(key));
+    if (it == index.end()) {
+        key_t s = {};
+        s.name = key;
+        s.type = type;
+        s.min = std::numeric_limits<double>::infinity();
+        s.max = -std::numeric_limits<double>::infinity();
+        s.intMin = std::numeric_limits<int64_t>::max();
+        s.intMax = std::numeric_limits<int64_t>::min();
+        it = index.emplace(s.name, stats.size()).first;
+        stats.push_back(std::move(s));
+    }
+    key_t& s = stats[it->second];
+    if (s.type != type) {
+        ++s.mismatches;
+        return;
+    }
+    ++s.frames;
+    s.values += num;
+
+    for (int i = 0; i < num; ++i) {
+        if (type == 'f') {
+            const double v = env->propGetFloat(map, key, i, nullptr);
+            s.min = std::min(s.min, v);
+            s.max = std::max(s.max, v);
+            s.sum += v;
+        } else if (type == 'i') {
+            const int64_t v = env->propGetInt(map, key, i, nullptr);
+            s.intMin = std::min(s.intMin, v);
+            s.intMax = std::max(s.intMax, v);
+            s.sum += static_cast<double>(v);
+            auto h = s.ints.find(v);
+            if (h != s.ints.end()) {
+                ++h->second;
+            } else if (s.ints.size() < maxDistinct) {
+                s.ints.emplace(v, 1);
+            } else {
+                ++s.others;
+            }
+        } else if (type == 's') {
+            const std::string_view v(env->propGetData(map, key, i, nullptr),
+                                     env->propGetDataSize(map, key, i, nullptr));
+            auto h = s.strings.find(v);
+            if (h != s.strings.end()) {
+                ++h->second;
+            } else if (s.strings.size() < maxDistinct) {
+                s.strings.emplace(v, 1);
+            } else {
+                ++s.others;
+            }
+        }
+    }
+}
+
+
+void PropStats::add(const AVSMap* map)
+{
+    ++frames;
+    if (keys.empty()) {
+        const int num = env->propNumKeys(map);
+        for (int i = 0; i < num; ++i) {
+            addProp(map, env->propGetKey(map, i));
+        }
+    } else {
+        for (const auto& key : keys) {
+            addProp(map, key.c_str());
+        }
+    }
+}
+
+
+// the most frequent values first.
+template <typename M>
+static std::vector<typename M::const_pointer> sort_histogram(const M& m)
+{
+    std::vector<typename M::const_pointer> v;
+    for (const auto& e : m) {
+        v.push_back(&e);
+    }
+    std::stable_sort(v.begin(), v.end(),
+                     [](auto a, auto b) { return a->second > b->second; });
+    return v;
+}
+
+
+void PropStats::print(const char* path, bool json)
+{
+    FILE* fp = stdout;
+    if (path) {
+        fp = fopen(path, "w");
+        validate(!fp, std::format("failed to open {}.\n", path));
+    }
+    const char* types[] = { "int", "float", "string", "binary" };
+    auto type_name = [&](char t) {
+        return types[t == 'i' ? 0 : t == 'f' ? 1 : t == 's' ? 2 : 3];
+    };
+
+    std::string text;
+    if (json) {
+        JsonWriter w(text);
+        w.beginObject();
+        w.key("frames");
+        w.value(static_cast<int64_t>(frames));
+        w.key("keys");
+        w.beginArray();
+        for (const auto& s : stats) {
+            w.beginObject();
+            w.key("name");
+            w.value(s.name);
+            w.key("type");
+            w.value(type_name(s.type));
+            w.key("frames");
+            w.value(s.frames);
+            w.key("values");
+            w.value(s.values);
+            if (s.type == 'i' && s.values > 0) {
+                w.key("min");
+                w.value(s.intMin);
+                w.key("max");
+                w.value(s.intMax);
+            } else if (s.type == 'f' && s.values > 0) {
+                w.key("min");
+                w.value(s.min, 7);
+                w.key("max");
+                w.value(s.max, 7);
+            }
+            if ((s.type == 'i' || s.type == 'f') && s.values > 0) {
+                w.key("mean");
+                w.value(s.sum / s.values, 7);
+            }
+            if (s.type == 'i' || s.type == 's') {
+                w.key("histogram");
+                w.beginArray();
+                if (s.type == 'i') {
+                    for (auto e : sort_histogram(s.ints)) {
+                        w.beginArray();
+                        w.value(e->first);
+                        w.value(e->second);
+                        w.endArray();
+                    }
+                } else {
+                    for (auto e : sort_histogram(s.strings)) {
+                        w.beginArray();
+                        w.value(e->first);
+                        w.value(e->second);
+                        w.endArray();
+                    }
+                }
+                w.endArray();
+                w.key("others");
+                w.value(s.others);
+            }
+            if (s.mismatches > 0) {
+                w.key("mismatches");
+                w.value(s.mismatches);
+            }
+            w.endObject();
+        }
+        w.endArray();
+        w.endObject();
+        text += '\n';
+    } else {
+        text = std::format("frames: {}\n", frames);
+        for (const auto& s : stats) {
+            text += std::format("{}  {}  {} frames", s.name, type_name(s.type),
+                                s.frames);
+            if (s.type == 'i' && s.values > 0) {
+                text += std::format("  min {}  max {}", s.intMin, s.intMax);
+            } else if (s.type == 'f' && s.values > 0) {
+                text += std::format("  min {:.6f}  max {:.6f}", s.min, s.max);
+            }
+            if ((s.type == 'i' || s.type == 'f') && s.values > 0) {
+                text += std::format("  mean {:.6f}", s.sum / s.values);
+            }
+            if (s.values != s.frames) {
+                text += std::format("  ({} values)", s.values);
+            }
+            if (s.mismatches > 0) {
+                text += std::format("  ({} frames of another type)", s.mismatches);
+            }
+            text += "\n";
+            if (s.type == 'i') {
+                for (auto e : sort_histogram(s.ints)) {
+                    text += std::format("    {}  {}\n", e->first, e->second);
+                }
+            } else if (s.type == 's') {
+                for (auto e : sort_histogram(s.strings)) {
+                    text += std::format("    \"{}\"  {}\n", e->first, e->second);
+                }
+            }
+            if (s.others > 0) {
+                text += std::format("    others  {}\n", s.others);
+            }
+        }
+    }
+    fwrite(text.data(), 1, text.size(), fp);
+    if (fp != stdout) {
+        fclose(fp);
+    } else {
+        fflush(fp);
+    }
+}
@@ -0,0 +1,71 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_PROPSTATS_H
+#define A2PM_PROPSTATS_H
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "avs2pipemod.h"
+
+
+// folds the frame properties of every frame into a summary of each key:
+// the frames that have it, min/max/mean of the elements of int and float
+// keys, and the counts of the distinct values of int and string keys. once
+// there are max_distinct values, new ones are only counted as others.
+class PropStats {
+    struct key_t {
+        std::string name;
+        char type;              // 'i', 'f', 's'tring or 'b'inary
+        int64_t frames;
+        int64_t values;         // elements, over all the frames
+        double min;             // of float keys
+        double max;
+        int64_t intMin;         // of int keys, exact beyond 2^53
+        int64_t intMax;
+        double sum;
+        std::map<int64_t, int64_t> ints;
+        std::map<std::string, int64_t, std::less<>> strings;
+        int64_t others;
+        int64_t mismatches;     // frames where the key had another type
+    };
+    ise_t* env;
+    std::vector<std::string> keys;      // all the keys of each frame if empty
+    std::vector<key_t> stats;
+    std::map<std::string, size_t, std::less<>> index;
+    size_t maxDistinct;
+    int frames;
+
+    void addProp(const AVSMap* map, const char* key);
+
+public:
+    // keys is the comma separated list of -props, or nullptr.
+    PropStats(ise_t* env, const char* keys, int max_distinct);
+    void add(const AVSMap* map);
+    // path is nullptr for stdout.
+    void print(const char* path, bool json);
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <format>
+#include "textdump.h"
+
+
+static constexpr auto digit_pairs = [] {
+    std::array<char, 200> a = {};
+    for (int i = 0; i < 100; ++i) {
+        a[2 * i] = static_cast<char>('0' + i / 10);
+        a[2 * i + 1] = static_cast<char>('0' + i % 10);
+    }
+    return a;
+}();
+
+
+// writes v and a tab, two digits at a time.
+static inline char* put_uint(char* p, uint32_t v)
+{
+    char buf[12];
+    char* end = buf + sizeof(buf);
+    char* s = end;
+    while (v >= 100) {
+        s -= 2;
+        memcpy(s, &digit_pairs[(v % 100) * 2], 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        s -= 2;
+        memcpy(s, &digit_pairs[v * 2], 2);
+    } else {
+        *--s = static_cast<char>('0' + v);
+    }
+    const size_t len = end - s;
+    memcpy(p, s, len);
+    p[len] = '\t';
+    return p + len + 1;
+}
+
+
+// same as printf's "%.8f\t".
+static inline char* put_float(char* p, float v)
+{
+    p = std::to_chars(p, p + 64, v, std::chars_format::fixed, 8).ptr;
+    *p = '\t';
+    return p + 1;
+}
+
+
+template <typename T>
+static char* put_rows(char* p, const plane_t& pl)
+{
+    const int width = pl.rowsize / static_cast<int>(sizeof(T));
+    const uint8_t* srcp = pl.ptr;
+    for (int y = 0; y < pl.height; ++y) {
+        const T* s = reinterpret_cast<const T*>(srcp);
+        for (int x = 0; x < width; ++x) {
+            if constexpr (sizeof(T) == 4) {
+                p = put_float(p, s[x]);
+            } else {
+                p = put_uint(p, s[x]);
+            }
+        }
+        *p++ = '\n';
+        srcp += pl.pitch;
+    }
+    return p;
+}
+
+
+TextDumper::TextDumper(int b, const std::vector<std::string>& t) :
+    FramePrinter(nullptr), bits(b), titles(t) {}
+
+
+TextDumper::~TextDumper()
+{
+    stopThreads();
+}
+
+
+// the text is written straight into a buffer that is large enough for the
+// longest values.
+void TextDumper::format(const job_t& job, std::string& text)
+{
+    const plane_t& pl = job.planes[0];
+    if (job.index == 0) {
+        text += std::format("frame {}\n", job.frame);
+    }
+    if (!titles.empty()) {
+        text += titles[job.index % titles.size()] + "\n";
+    }
+
+    const size_t bytes = bits == 8 ? 1 : bits == 32 ? 4 : 2;
+    const size_t chars = bits == 32 ? 64 : 6;
+    const size_t pos = text.size();
+    text.resize(pos + (pl.rowsize / bytes * chars + 1) * pl.height + 1);
+    char* p = text.data() + pos;
+    p = bits == 8 ? put_rows<uint8_t>(p, pl) :
+        bits == 32 ? put_rows<float>(p, pl) : put_rows<uint16_t>(p, pl);
+    *p++ = '\n';
+    text.resize(p - text.data());
+}
+
+
+void TextDumper::add(int n, int index, const plane_t& plane,
+                     const PVideoFrame& owner)
+{
+    FramePrinter::add(n, index, &plane, 1, owner);
+}
@@ -0,0 +1,50 @@
+/*
+* Copyright (C) 2026 agent <agent at local>
+*
+* This file is part of avs2pipemod.
+*
+* avs2pipemod is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* avs2pipemod is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with avs2pipemod.  If not, see <http://www.gnu.org/licenses/>.
+*
+*/
+
+
+
+#ifndef A2PM_TEXTDUMP_H
+#define A2PM_TEXTDUMP_H
+
+#include <string>
+#include <vector>
+#include "frameprinter.h"
+
+
+// formats planes as the tab separated text of -dumptxt on a pool of threads.
+// every plane is formatted on its own.
+class TextDumper : public FramePrinter {
+    int bits;
+    std::vector<std::string> titles;
+
+    void format(const job_t& job, std::string& text) override;
+
+public:
+    // writes to stdout. bits is the bit depth of the samples, 32 for float.
+    // titles are printed before the planes, none if empty.
+    TextDumper(int bits, const std::vector<std::string>& titles);
+    ~TextDumper();
+    // index is the number of the plane in the frame, counting on over the
+    // fields, and titles repeat for every field. the first one is preceded
+    // by the frame number.
+    void add(int n, int index, const plane_t& plane, const PVideoFrame& owner);
+};
+
+#endif
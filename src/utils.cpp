@@ -20,6 +20,10 @@
 
 
 #include <cstdio>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
 #if defined(_WIN32)
 #define WIN32_LEAN_AND_MEAN
 #define VC_EXTRALEAN
@@ -267,6 +271,19 @@ int get_sample_bits(int pixel_type)
     return 0;
 }
 
+int set_sample_bits(int pixel_type, int bits)
+{
+    pixel_type &= ~VideoInfo::CS_Sample_Bits_Mask;
+    switch (bits) {
+    case 10: return pixel_type | VideoInfo::CS_Sample_Bits_10;
+    case 12: return pixel_type | VideoInfo::CS_Sample_Bits_12;
+    case 14: return pixel_type | VideoInfo::CS_Sample_Bits_14;
+    case 16: return pixel_type | VideoInfo::CS_Sample_Bits_16;
+    case 32: return pixel_type | VideoInfo::CS_Sample_Bits_32;
+    }
+    return pixel_type | VideoInfo::CS_Sample_Bits_8;
+}
+
 int get_num_planes(int pixel_type)
 {
     if (pixel_type & VideoInfo::CS_INTERLEAVED) {
@@ -313,6 +330,30 @@ void convert_channelmask_to_string(uint32_t cm, std::string& cmstr)
     }
 }
 
+bool has_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    constexpr int OSXSAVE = 1 << 27, AVX = 1 << 28;
+    if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX)) {
+        return false;
+    }
+    // OS saves xmm and ymm registers.
+    if ((_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
 #if 0
 const char* get_string_filter(int pix_type)
 {
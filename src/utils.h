@@ -50,10 +50,14 @@ const char* get_string_y4mheader(int pix_type, int chromaloc);
 
 int get_sample_bits(int pixel_type);
 
+int set_sample_bits(int pixel_type, int bits);
+
 int get_num_planes(int pixel_type);
 
 void convert_channelmask_to_string(uint32_t cm, std::string& cmstr);
 
+bool has_avx2();
+
 //const char* get_string_filter(int pix_type);
 
 class Buffer {